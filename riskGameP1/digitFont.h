@@ -0,0 +1,93 @@
+#ifndef _DIGIT_FONT_H
+#define _DIGIT_FONT_H
+
+#include <Arduino.h>
+#include "tftStats.h"
+
+/*
+  The digits of the display's built-in 5x7 font, cut into rectangles.
+
+  Printing at text size 2 or 3 makes the library fill one little square
+  per lit pixel of the font, each with its own address window, which is
+  151 windows for the ten digits. Covering each digit with as few
+  rectangles as possible gets that down to 59, and the pixels that end
+  up on screen are the same as printing.
+
+  Each rectangle is two bytes in font pixels: (x << 4 | y, w << 4 | h).
+*/
+const uint8_t DIGIT_RECTS[] PROGMEM = {
+  // 0
+  0x01, 0x15, 0x41, 0x15, 0x10, 0x31, 0x16, 0x31, 0x14, 0x11, 0x23, 0x11, 0x32, 0x11,
+  // 1
+  0x20, 0x17, 0x16, 0x31, 0x11, 0x11,
+  // 2
+  0x06, 0x51, 0x10, 0x31, 0x13, 0x31, 0x04, 0x12, 0x41, 0x12, 0x01, 0x11,
+  // 3
+  0x00, 0x51, 0x16, 0x31, 0x23, 0x21, 0x44, 0x12, 0x05, 0x11, 0x32, 0x11, 0x41, 0x11,
+  // 4
+  0x30, 0x17, 0x04, 0x51, 0x03, 0x11, 0x12, 0x11, 0x21, 0x11,
+  // 5
+  0x00, 0x51, 0x02, 0x41, 0x16, 0x31, 0x43, 0x13, 0x01, 0x11, 0x05, 0x11,
+  // 6
+  0x02, 0x14, 0x13, 0x31, 0x16, 0x31, 0x20, 0x31, 0x44, 0x12, 0x11, 0x11,
+  // 7
+  0x00, 0x51, 0x41, 0x12, 0x06, 0x11, 0x15, 0x11, 0x24, 0x11, 0x33, 0x11,
+  // 8
+  0x10, 0x31, 0x13, 0x31, 0x16, 0x31, 0x01, 0x12, 0x04, 0x12, 0x41, 0x12, 0x44, 0x12,
+  // 9
+  0x13, 0x41, 0x06, 0x31, 0x10, 0x31, 0x41, 0x14, 0x01, 0x12, 0x35, 0x11
+};
+
+// where each digit's rectangles start in DIGIT_RECTS, digit d has
+// DIGIT_START[d + 1] - DIGIT_START[d] of them
+const uint8_t DIGIT_START[11] PROGMEM = {0, 7, 10, 16, 23, 28, 34, 40, 46, 53, 59};
+
+// draws one digit the way printing it at text size scale would
+/*
+Takes in:   display (the screen)
+            x, y (top left corner of the character, like the text cursor)
+            digit (0 to 9)
+            scale (the text size it replaces)
+            color (the text color)
+
+Returns:    Nothing
+*/
+void drawDigit(Display &display, int16_t x, int16_t y, uint8_t digit, uint8_t scale, uint16_t color) {
+  uint8_t end = pgm_read_byte(&DIGIT_START[digit + 1]);
+  for (uint8_t i = pgm_read_byte(&DIGIT_START[digit]); i < end; i++) {
+    uint8_t corner = pgm_read_byte(&DIGIT_RECTS[2*i]);
+    uint8_t size = pgm_read_byte(&DIGIT_RECTS[2*i + 1]);
+    display.fillRect(x + (corner >> 4) * scale, y + (corner & 0x0F) * scale,
+                     (size >> 4) * scale, (size & 0x0F) * scale, color);
+  }
+}
+
+// draws a number the way printing it at text size scale would, with a
+// minus sign if it is negative. Each character is 6 * scale wide
+/*
+Takes in:   display (the screen)
+            x, y (top left corner of the first character)
+            value (the number)
+            scale (the text size it replaces)
+            color (the text color)
+
+Returns:    Nothing
+*/
+void drawNumber(Display &display, int16_t x, int16_t y, int16_t value, uint8_t scale, uint16_t color) {
+  // the font's minus is its fourth row, all five columns lit
+  uint16_t rest = abs((int32_t) value);
+  if (value < 0) {
+    display.fillRect(x, y + 3 * scale, 5 * scale, scale, color);
+    x += 6 * scale;
+  }
+  uint16_t place = 1;
+  while (rest / place >= 10) {
+    place *= 10;
+  }
+  for (; place > 0; place /= 10) {
+    drawDigit(display, x, y, (rest / place) % 10, scale, color);
+    x += 6 * scale;
+  }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef _MAP_DATA_H
+#define _MAP_DATA_H
+
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+
+/*
+  A map compiled into flash, used instead of map.txt when MAP_IN_FLASH
+  is defined. Nothing here is copied into RAM except each territory's
+  starting team and power.
+
+  The tables hold the same information as map.txt:
+    MAP_INFO    - one record per T line, indexed by territory id
+    MAP_OFFSETS - territory t's roads are MAP_ROADS[MAP_OFFSETS[t]] up to
+                  MAP_ROADS[MAP_OFFSETS[t+1] - 1]
+    MAP_ROADS   - every P line listed under both of its territories
+
+  Written by test/mapdata.cpp, don't edit it by hand. To compile in a
+  different map, run 'make mapdata MAP=path/to/map.txt' in test/.
+*/
+
+#define MAP_TERRITORIES 16
+#define MAP_CONTINENTS 4
+#define MAP_NUM_ROADS 26
+
+// one T line of map.txt (the id is the index in MAP_INFO)
+struct terrInfo
+{
+    uint16_t x;
+    uint16_t y;
+    //starting owner
+    uint8_t team;
+    uint8_t cont;
+    uint8_t type;
+    uint8_t magnitude;
+    //starting armies
+    uint8_t power;
+};
+
+const terrInfo MAP_INFO[MAP_TERRITORIES] PROGMEM = {
+    // x,   y, team, cont, type, magnitude, power
+    { 20,  30, 1, 0, 0, 0, 3}, // 0
+    { 80,  70, 2, 0, 0, 0, 3}, // 1
+    { 30, 130, 1, 0, 0, 0, 3}, // 2
+    { 90, 180, 2, 0, 4, 2, 3}, // 3
+    {160,  40, 2, 1, 0, 0, 3}, // 4
+    {220, 100, 1, 1, 0, 0, 3}, // 5
+    {150, 160, 2, 1, 3, 1, 3}, // 6
+    {230, 200, 1, 1, 0, 0, 3}, // 7
+    {300,  30, 1, 2, 0, 0, 3}, // 8
+    {360,  90, 2, 2, 1, 1, 3}, // 9
+    {310, 170, 1, 2, 0, 0, 3}, // 10
+    {380, 200, 2, 2, 0, 0, 3}, // 11
+    {440,  40, 2, 3, 4, 2, 3}, // 12
+    {500, 100, 1, 3, 0, 0, 3}, // 13
+    {430, 150, 2, 3, 0, 0, 3}, // 14
+    {510, 190, 1, 3, 0, 0, 3}, // 15
+};
+
+const uint16_t MAP_OFFSETS[MAP_TERRITORIES + 1] PROGMEM = {
+    0, 2, 6, 9, 12, 15, 19, 23, 26, 29, 33, 37, 40, 43, 46, 50, 52
+};
+
+const uint8_t MAP_ROADS[2 * MAP_NUM_ROADS] PROGMEM = {
+    1, 2,           // 0
+    0, 2, 3, 4,     // 1
+    0, 1, 3,        // 2
+    1, 2, 6,        // 3
+    1, 5, 6,        // 4
+    4, 6, 7, 8,     // 5
+    3, 4, 5, 7,     // 6
+    5, 6, 10,       // 7
+    5, 9, 10,       // 8
+    8, 10, 11, 12,  // 9
+    7, 8, 9, 11,    // 10
+    9, 10, 14,      // 11
+    9, 13, 14,      // 12
+    12, 14, 15,     // 13
+    11, 12, 13, 15, // 14
+    13, 14,         // 15
+};
+
+#endif
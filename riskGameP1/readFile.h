@@ -24,6 +24,43 @@ int readNumber(File& file)
   }
 }
 
+// reads one "P from to" road line, returns false if the line is not a road
+bool readRoad(File& file, int& from, int& to)
+{
+  char current = file.read();
+  file.read();
+  if (current != 'P')
+  {
+    Serial.println("Incorrect file format P");
+    Serial.println(current);
+    return false;
+  }
+  from = readNumber(file);
+  to = readNumber(file);
+  return true;
+}
+
+#ifdef MAP_IN_FLASH
+// builds the map compiled into mapData.h, only the team and power of each
+// territory are copied into RAM and the roads are read from flash
+masterMapGraph* makeMap(territory *&allTerritories) {
+  masterMapGraph *map = new masterMapGraph(MAP_TERRITORIES, MAP_CONTINENTS, MAP_NUM_ROADS);
+
+  allTerritories = new territory[MAP_TERRITORIES];
+  for (int i = 0; i < MAP_TERRITORIES; ++i)
+  {
+    allTerritories[i].id = i;
+    allTerritories[i].team = pgm_read_byte(&MAP_INFO[i].team);
+    allTerritories[i].power = pgm_read_byte(&MAP_INFO[i].power);
+    map->addVertex(allTerritories[i]);
+  }
+  //the roads are already laid out in flash, nothing to count or add
+  map->reserve(NULL);
+  map->compact();
+  Serial.println("Finished Reading");
+  return map;
+}
+#else
 masterMapGraph* makeMap(territory *&allTerritories) {
   File file;
 
@@ -67,7 +104,7 @@ masterMapGraph* makeMap(territory *&allTerritories) {
     }
   }
 
-  masterMapGraph *map = new masterMapGraph(parameters[0], parameters[2]);
+  masterMapGraph *map = new masterMapGraph(parameters[0], parameters[2], parameters[1]);
 
   allTerritories = new territory[parameters[0]];
   territory newTerr;
@@ -100,38 +137,50 @@ masterMapGraph* makeMap(territory *&allTerritories) {
     parameter = readNumber(file);
     newTerr.power = parameter;
 
-    map->addVertex(newTerr);
+    allTerritories[newTerr.id] = newTerr;
 
-    delay(50);
+    map->addVertex(newTerr);
+  }
 
-    allTerritories[newTerr.id] = newTerr;
+  //first pass over the roads: count how many each territory has so the
+  //map can allocate all of its neighbour storage in one go
+  uint32_t roadStart = file.position();
+  uint8_t *degree = new uint8_t[parameters[0]];
+  for (int i = 0; i < parameters[0]; ++i)
+  {
+    degree[i] = 0;
   }
 
-  territory from;
-  territory to;
+  int from;
+  int to;
   for (int i = 0; i < parameters[1]; ++i)
   {
-    current = file.read();
-    file.read();
-    if (current != 'P')
+    if (!readRoad(file, from, to))
     {
       file.close();
-      Serial.println("Incorrect file format P");
-      Serial.println(current);
+      delete[] degree;
       masterMapGraph temp = masterMapGraph(0,0);
       return &temp;
     }
+    degree[from]++;
+    degree[to]++;
+  }
+  map->reserve(degree);
+  delete[] degree;
 
-    parameter = readNumber(file);
-    from = allTerritories[parameter];
-    parameter = readNumber(file);
-    to =  allTerritories[parameter];
-
-    map->addEdge(from, to);
+  //second pass: go back and fill in the roads
+  file.seek(roadStart);
+  for (int i = 0; i < parameters[1]; ++i)
+  {
+    readRoad(file, from, to);
+    map->addEdge(allTerritories[from], allTerritories[to]);
   }
+  //every edge is in, tidy up the topology
+  map->compact();
   Serial.println("Finished Reading");
   file.close();
   return map;
 }
+#endif
 
 #endif
\ No newline at end of file
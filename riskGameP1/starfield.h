@@ -0,0 +1,72 @@
+#ifndef _STARFIELD_H
+#define _STARFIELD_H
+
+#include <Arduino.h>
+#include "tftStats.h"
+#include "viewport.h"
+
+// the sky is tiled with blocks of STAR_BLOCK x STAR_BLOCK map pixels
+#define STAR_BLOCK 128
+#define STAR_COUNT 60
+
+/*
+  The stars in one block of the sky, about as many per pixel as the old
+  250 random stars per screen. Every block uses the same stars, moved
+  around by a pattern picked from where the block is, so the sky doesn't
+  look tiled. The stars belong to the map, so they are in the same place
+  every time a part of the map is drawn, and move with it when it pans.
+*/
+const uint8_t STARS[STAR_COUNT][2] PROGMEM = {
+  {115, 82}, {79, 38}, {9, 101}, {46, 12}, {69, 18}, {12, 24},
+  {78, 93}, {108, 14}, {123, 54}, {76, 9}, {0, 22}, {1, 111},
+  {6, 107}, {113, 17}, {78, 61}, {28, 23}, {86, 108}, {16, 15},
+  {88, 31}, {19, 57}, {107, 15}, {70, 101}, {88, 12}, {76, 56},
+  {118, 11}, {11, 34}, {17, 74}, {38, 107}, {118, 36}, {19, 30},
+  {124, 78}, {34, 46}, {48, 26}, {12, 48}, {42, 95}, {120, 24},
+  {9, 16}, {33, 15}, {92, 52}, {10, 127}, {59, 109}, {53, 80},
+  {24, 119}, {1, 116}, {72, 92}, {94, 76}, {76, 63}, {2, 46},
+  {62, 62}, {122, 20}, {110, 76}, {95, 126}, {119, 87}, {115, 114},
+  {91, 73}, {94, 18}, {28, 30}, {5, 107}, {29, 42}, {72, 87}
+};
+
+// draws the stars in a box of the screen that was just cleared, in one
+// batch of pixel writes
+/*
+Takes in:   display (the screen)
+            view (the part of the map on screen)
+            x, y, w, h (the box that was cleared, in screen coordinates)
+            color (the color of the stars)
+
+Returns:    Nothing
+*/
+void drawStarfield(Display &display, const viewport &view, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  // the box on the map
+  int16_t left = max(x, (int16_t) 0) + view.left;
+  int16_t top = max(y, (int16_t) 0) + view.top;
+  int16_t right = min((int16_t) (x + w), view.width) + view.left;
+  int16_t bottom = min((int16_t) (y + h), view.height) + view.top;
+  if (right <= left || bottom <= top) {
+    return;
+  }
+
+  display.startWrite();
+  for (int16_t blockY = top / STAR_BLOCK; blockY <= (bottom - 1) / STAR_BLOCK; blockY++) {
+    for (int16_t blockX = left / STAR_BLOCK; blockX <= (right - 1) / STAR_BLOCK; blockX++) {
+      // flipping some of the coordinate bits moves the stars around
+      // without bunching them up
+      uint8_t flipX = (blockX * 37 + blockY * 101) & (STAR_BLOCK - 1);
+      uint8_t flipY = (blockX * 83 + blockY * 29) & (STAR_BLOCK - 1);
+
+      for (uint8_t i = 0; i < STAR_COUNT; i++) {
+        int16_t starX = blockX * STAR_BLOCK + (pgm_read_byte(&STARS[i][0]) ^ flipX);
+        int16_t starY = blockY * STAR_BLOCK + (pgm_read_byte(&STARS[i][1]) ^ flipY);
+        if (starX >= left && starX < right && starY >= top && starY < bottom) {
+          display.writePixel(starX - view.left, starY - view.top, color);
+        }
+      }
+    }
+  }
+  display.endWrite();
+}
+
+#endif
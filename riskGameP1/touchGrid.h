@@ -0,0 +1,130 @@
+#ifndef _TOUCH_GRID_H
+#define _TOUCH_GRID_H
+
+#include <Arduino.h>
+#include "mapGraph.h"
+
+// cells start at 32x32 pixels, a little bigger than a territory
+#define GRID_CELL_SHIFT 5
+// the cells are made bigger until there are at most this many of them
+#define GRID_MAX_CELLS 256
+
+/*
+  Buckets the territories by where they are on the map, so a touch only
+  has to be checked against the few territories in the cell it lands in.
+  A territory is listed in every cell its box overlaps, so territories
+  stacked in the same column are all found.
+
+  The cells' lists are stored one after another in ids: cell c's
+  territories are ids[first[c]] up to (not including) ids[first[c + 1]].
+*/
+class touchGrid {
+public:
+  touchGrid() {
+    first = NULL;
+    ids = NULL;
+    cols = 0;
+    rows = 0;
+    shift = GRID_CELL_SHIFT;
+  }
+
+  ~touchGrid() {
+    delete[] first;
+    delete[] ids;
+  }
+
+  // buckets every territory, call once the map is loaded
+  /*
+  Takes in:   count (how many territories there are)
+              mapWidth, mapHeight (how far the territories reach)
+              boxWidth, boxHeight (the size of a territory)
+  */
+  void build(uint8_t count, uint16_t mapWidth, uint16_t mapHeight, uint8_t boxWidth, uint8_t boxHeight) {
+    delete[] first;
+    delete[] ids;
+    width = boxWidth;
+    height = boxHeight;
+
+    shift = GRID_CELL_SHIFT;
+    while ((uint32_t) cellsFor(mapWidth) * cellsFor(mapHeight) > GRID_MAX_CELLS) {
+      shift++;
+    }
+    cols = cellsFor(mapWidth);
+    rows = cellsFor(mapHeight);
+    uint16_t cells = cols * rows;
+
+    // count each cell's territories one entry along, so the prefix sums
+    // give each cell's start
+    first = new uint16_t[cells + 1];
+    for (uint16_t c = 0; c <= cells; c++) {
+      first[c] = 0;
+    }
+    for (uint8_t id = 0; id < count; id++) {
+      for (uint16_t row = rowOf(terrY(id)); row <= rowOf(terrY(id) + height - 1); row++) {
+        for (uint16_t col = colOf(terrX(id)); col <= colOf(terrX(id) + width - 1); col++) {
+          first[row * cols + col + 1]++;
+        }
+      }
+    }
+    for (uint16_t c = 0; c < cells; c++) {
+      first[c + 1] += first[c];
+    }
+
+    // fill the lists, first[c] moves to the end of cell c as it fills,
+    // which is where cell c + 1 starts
+    ids = new uint8_t[first[cells]];
+    for (uint8_t id = 0; id < count; id++) {
+      for (uint16_t row = rowOf(terrY(id)); row <= rowOf(terrY(id) + height - 1); row++) {
+        for (uint16_t col = colOf(terrX(id)); col <= colOf(terrX(id) + width - 1); col++) {
+          ids[first[row * cols + col]++] = id;
+        }
+      }
+    }
+    for (uint16_t c = cells; c > 0; c--) {
+      first[c] = first[c - 1];
+    }
+    first[0] = 0;
+  }
+
+  // finds the territory at a point on the map
+  /*
+  Takes in:   x, y (map coordinates of the touch)
+
+  Returns:    the id of the territory there (-1 if there isn't one)
+  */
+  int find(int16_t x, int16_t y) const {
+    if (x < 0 || y < 0 || colOf(x) >= cols || rowOf(y) >= rows) {
+      return -1;
+    }
+    uint16_t c = rowOf(y) * cols + colOf(x);
+    for (uint16_t i = first[c]; i < first[c + 1]; i++) {
+      uint8_t id = ids[i];
+      if (x > terrX(id) && x < terrX(id) + width && y > terrY(id) && y < terrY(id) + height) {
+        return id;
+      }
+    }
+    return -1;
+  }
+
+private:
+  uint16_t *first;
+  uint8_t *ids;
+  uint16_t cols, rows;
+  // cells are (1 << shift) pixels square
+  uint8_t shift;
+  uint8_t width, height;
+
+  uint16_t cellsFor(uint16_t length) const {
+    return (length >> shift) + 1;
+  }
+
+  uint16_t colOf(uint16_t x) const {
+    return x >> shift;
+  }
+
+  uint16_t rowOf(uint16_t y) const {
+    return y >> shift;
+  }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef _VIEWPORT_H
+#define _VIEWPORT_H
+
+#include <Arduino.h>
+
+// Cohen-Sutherland outcodes, which sides of the view a point is past
+#define OUT_LEFT   1
+#define OUT_RIGHT  2
+#define OUT_TOP    4
+#define OUT_BOTTOM 8
+
+/*
+  The part of the map that is on screen. left/top is the map coordinate
+  shown in the top left corner of the map area, and width/height is the
+  size of the map area (the side bar is not part of it).
+
+  Everything takes map coordinates and hands back screen coordinates,
+  so shapes that are off screen are dropped before they reach the
+  display driver and shapes that are partly off screen never spill
+  into the side bar.
+*/
+struct viewport {
+  int16_t left, top;
+  int16_t width, height;
+
+  // checks if any of a box lands in the view
+  bool overlaps(int16_t x, int16_t y, int16_t w, int16_t h) const {
+    return x < left + width && x + w > left && y < top + height && y + h > top;
+  }
+
+  // checks if a point lands in the view
+  bool contains(int16_t x, int16_t y) const {
+    return outcode(x, y) == 0;
+  }
+
+  // cuts a box down to the part in the view and moves it to screen
+  // coordinates, returns false if none of it is in the view
+  bool clipBox(int16_t &x, int16_t &y, int16_t &w, int16_t &h) const {
+    int16_t x1 = min(x + w, left + width);
+    int16_t y1 = min(y + h, top + height);
+    x = max(x, left);
+    y = max(y, top);
+    if (x1 <= x || y1 <= y) {
+      return false;
+    }
+    w = x1 - x;
+    h = y1 - y;
+    x -= left;
+    y -= top;
+    return true;
+  }
+
+  // cuts a line down to the part in the view (Cohen-Sutherland) and moves
+  // it to screen coordinates, returns false if none of it is in the view
+  bool clipLine(int16_t &x0, int16_t &y0, int16_t &x1, int16_t &y1) const {
+    uint8_t out0 = outcode(x0, y0);
+    uint8_t out1 = outcode(x1, y1);
+
+    while (out0 | out1) {
+      // both ends are past the same side
+      if (out0 & out1) {
+        return false;
+      }
+
+      // move the end that is outside onto the edge it is past
+      uint8_t out = out0 ? out0 : out1;
+      int32_t x, y;
+      int16_t right = left + width - 1;
+      int16_t bottom = top + height - 1;
+      if (out & OUT_TOP) {
+        x = x0 + (int32_t) (x1 - x0) * (top - y0) / (y1 - y0);
+        y = top;
+      }
+      else if (out & OUT_BOTTOM) {
+        x = x0 + (int32_t) (x1 - x0) * (bottom - y0) / (y1 - y0);
+        y = bottom;
+      }
+      else if (out & OUT_LEFT) {
+        y = y0 + (int32_t) (y1 - y0) * (left - x0) / (x1 - x0);
+        x = left;
+      }
+      else {
+        y = y0 + (int32_t) (y1 - y0) * (right - x0) / (x1 - x0);
+        x = right;
+      }
+
+      if (out == out0) {
+        x0 = x;
+        y0 = y;
+        out0 = outcode(x0, y0);
+      }
+      else {
+        x1 = x;
+        y1 = y;
+        out1 = outcode(x1, y1);
+      }
+    }
+
+    x0 -= left;
+    x1 -= left;
+    y0 -= top;
+    y1 -= top;
+    return true;
+  }
+
+private:
+  uint8_t outcode(int16_t x, int16_t y) const {
+    uint8_t code = 0;
+    if (x < left) {
+      code |= OUT_LEFT;
+    }
+    else if (x >= left + width) {
+      code |= OUT_RIGHT;
+    }
+    if (y < top) {
+      code |= OUT_TOP;
+    }
+    else if (y >= top + height) {
+      code |= OUT_BOTTOM;
+    }
+    return code;
+  }
+};
+
+#endif
@@ -4,123 +4,954 @@
 #include <Arduino.h>
 #include "mapGraph.h"
 
-//read one 'word' at a time
-String timedRead(const int patience) {
-  String input;
-  char current;
-  uint32_t startTime = millis();
-
-  while (true) {
-    if (Serial3.available() != 0) {
-      current = Serial3.read();
-      //if there is a separating character, return the string
-      //therefore splitting characters automatically 
-      if (current != '\n' and current != ' ') {
-        input += current;
-      }
-      else {
-        return input;
-      }
-    }
-    else if ((millis() - startTime) > patience) {
-      return "";
-    }
-  }
-}
-//wait for a character to be recieved in serial mon(used in send+wait)
-bool wait(char target)
+/*
+  The board goes over the link in binary frames:
+
+    FRAME_SYNC, type, length, payload (length bytes), CRC-16 (high, low)
+
+  The CRC (CCITT, starting at 0xFFFF) covers the type, length and
+  payload, so a frame that was cut short or garbled is dropped and the
+  decoder goes back to looking for FRAME_SYNC.
+
+  A board is FRAME_TERRITORIES frames of TERRITORY_RECORD_SIZE byte
+  records, then a FRAME_BOARD_END frame with how many records were sent.
+  Usually only the territories that changed during the turn are sent.
+  The other board answers a board with BOARD_ACK, or if it can't make
+  sense of what it got, with SNAPSHOT_REQUEST and the whole board is
+  sent next time.
+
+  Before a board, FRAME_HELLO asks if the other board is listening and
+  FRAME_READY says it is. These and the answers to a board are frames
+  with no payload, so they are CRC checked like the rest. Bytes outside
+  of a frame are never taken as a message, e.g. what is left of a frame
+  whose length was garbled.
+
+  Both boards start at LINK_RATES[0]. Player 1 sends FRAME_HELLO once a
+  second until FRAME_READY comes back, as player 2 only answers once its
+  setup is done (the welcome screen alone is 5 seconds), and gives up
+  after LINK_START_LIMIT tries. It then proposes each faster rate from
+  the top down in a FRAME_RATE frame. The other board answers
+  and switches, the test pattern goes there and back at the new rate,
+  and player 1 confirms with the same FRAME_RATE. If the confirmation
+  doesn't come, the other board goes back to LINK_RATES[0] after
+  LINK_TRIAL_TIME. If a proposal goes unanswered LINK_PROPOSE_LIMIT
+  times, player 1 stops and both stay at LINK_RATES[0]. Later, a board that gets LINK_ERROR_LIMIT garbled
+  frames at a rate answers a board with a FRAME_RATE one step down
+  instead, and a sender that gets no answer LINK_RETRY_LIMIT times in a
+  row steps down on its own. A receiver that hears nothing but garbage
+  for LINK_SILENCE_TIME follows it down.
+*/
+#define FRAME_SYNC 0xA5
+// the biggest payload, a multiple of the record size
+#define FRAME_MAX_PAYLOAD 96
+
+// frame types
+#define FRAME_TERRITORIES 'T'
+#define FRAME_BOARD_END 'E'
+// one byte, an index into LINK_RATES
+#define FRAME_RATE 'S'
+// LINK_TEST_SIZE bytes of testByte(), sent back as they came
+#define FRAME_TEST 'P'
+
+// control frames, no payload
+#define FRAME_HELLO 'A'
+#define FRAME_READY 'R'
+// the answers to a board
+#define BOARD_ACK 'K'
+#define SNAPSHOT_REQUEST 'F'
+
+// how many received messages can wait for the game to take them
+#define LINK_QUEUE_SIZE 4
+// how many bytes can wait to be sent, on top of the serial port's own
+// buffer
+#define LINK_TX_SIZE 128
+// the serial port's transmit buffer (SERIAL_BUFFER_SIZE in the core's
+// HardwareSerial.cpp, 64 on the Mega)
+#define LINK_PORT_BUFFER 64
+
+// the rates the link can run at, slowest first
+#define LINK_RATE_COUNT 5
+const uint32_t LINK_RATES[LINK_RATE_COUNT] PROGMEM = {9600, 19200, 38400, 57600, 115200};
+// how long a proposed rate has to be confirmed in (ms)
+#define LINK_TRIAL_TIME 1000
+// FRAME_HELLOs without an answer before player 1 gives up on faster
+// rates, a second apart. Long enough for the other board's setup
+#define LINK_START_LIMIT 15
+// proposals of one rate without an answer before player 1 gives up on
+// faster rates, a second apart
+#define LINK_PROPOSE_LIMIT 5
+// garbled frames at one rate before it drops to the one below
+#define LINK_ERROR_LIMIT 4
+// boards in a row without an answer before the sender drops a rate
+#define LINK_RETRY_LIMIT 3
+// how long a receiver hears only garbage before it drops a rate (ms)
+#define LINK_SILENCE_TIME 3000
+#define LINK_TEST_SIZE 32
+
+// a territory record: id, then the team in the top 2 bits of a 16 bit
+// word (high byte first) with the power in the 14 bits below
+#define TERRITORY_RECORD_SIZE 3
+
+// adds a byte to a CRC-16 (CCITT)
+uint16_t crc16(uint16_t crc, uint8_t data) {
+  crc ^= (uint16_t) data << 8;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    if (crc & 0x8000) {
+      crc = (crc << 1) ^ 0x1021;
+    }
+    else {
+      crc <<= 1;
+    }
+  }
+  return crc;
+}
+
+// the test pattern, every bit of a byte flips somewhere in it and it
+// includes FRAME_SYNC
+uint8_t testByte(uint8_t i) {
+  return i * 97 + 0x5A;
+}
+
+// writes a frame a byte at a time, so the payload never has to be in
+// memory all at once
+class FrameEncoder {
+public:
+  FrameEncoder(Print &link) : out(link) {
+    crc = 0xFFFF;
+  }
+
+  // starts a frame, then exactly length bytes have to be put
+  void begin(uint8_t type, uint8_t length) {
+    crc = 0xFFFF;
+    out.write((uint8_t) FRAME_SYNC);
+    put(type);
+    put(length);
+  }
+
+  void put(uint8_t data) {
+    crc = crc16(crc, data);
+    out.write(data);
+  }
+
+  // sends the CRC
+  void end() {
+    out.write((uint8_t) (crc >> 8));
+    out.write((uint8_t) (crc & 0xFF));
+  }
+
+private:
+  Print &out;
+  uint16_t crc;
+};
+
+// puts together frames from the bytes as they come in
+class FrameDecoder {
+public:
+  FrameDecoder() {
+    state = WAIT_SYNC;
+    badFrames = 0;
+  }
+
+  // takes the next byte from the link
+  /*
+  Takes in:   data (the byte)
+
+  Returns:    true if it finished a frame with a good CRC, which can be
+              read until the next call
+  */
+  bool feed(uint8_t data) {
+    switch (state) {
+      case WAIT_SYNC:
+        if (data == FRAME_SYNC) {
+          crc = 0xFFFF;
+          state = TYPE;
+        }
+        return false;
+      case TYPE:
+        frameType = data;
+        crc = crc16(crc, data);
+        state = LENGTH;
+        return false;
+      case LENGTH:
+        if (data > FRAME_MAX_PAYLOAD) {
+          // can't be a frame, look for the next one
+          badFrames++;
+          state = WAIT_SYNC;
+          return false;
+        }
+        frameLength = data;
+        received = 0;
+        crc = crc16(crc, data);
+        state = frameLength > 0 ? PAYLOAD : CRC_HIGH;
+        return false;
+      case PAYLOAD:
+        buffer[received++] = data;
+        crc = crc16(crc, data);
+        if (received == frameLength) {
+          state = CRC_HIGH;
+        }
+        return false;
+      case CRC_HIGH:
+        crc ^= (uint16_t) data << 8;
+        state = CRC_LOW;
+        return false;
+      default:
+        crc ^= data;
+        state = WAIT_SYNC;
+        if (crc != 0) {
+          badFrames++;
+          return false;
+        }
+        return true;
+    }
+  }
+
+  // checks if it is between frames
+  bool idle() const {
+    return state == WAIT_SYNC;
+  }
+
+  // the frame that was just finished
+  uint8_t type() const {
+    return frameType;
+  }
+
+  uint8_t length() const {
+    return frameLength;
+  }
+
+  const uint8_t* payload() const {
+    return buffer;
+  }
+
+  // how many frames were dropped because they were garbled
+  uint16_t errors() const {
+    return badFrames;
+  }
+
+private:
+  enum State {WAIT_SYNC, TYPE, LENGTH, PAYLOAD, CRC_HIGH, CRC_LOW};
+  State state;
+  uint8_t frameType;
+  uint8_t frameLength;
+  uint8_t received;
+  uint16_t crc;
+  uint16_t badFrames;
+  uint8_t buffer[FRAME_MAX_PAYLOAD];
+};
+
+// a message from the other board
+struct linkEvent {
+  // the frame type
+  uint8_t type;
+  // the payload, empty for a control frame
+  uint8_t length;
+  uint8_t payload[FRAME_MAX_PAYLOAD];
+};
+
+/*
+  Turns the bytes from the other board into linkEvents, without ever
+  waiting for them. poll() takes whatever is in the serial port's receive
+  buffer, or feed() can be called with each byte as it arrives. The
+  finished messages wait in a small ring buffer until next() hands them
+  to the game.
+*/
+class LinkReceiver {
+public:
+  LinkReceiver() {
+    head = 0;
+    count = 0;
+    dropped = 0;
+    overflowed = 0;
+  }
+
+  // reads the bytes that have come in so far
+  void poll(Stream &link) {
+    while (link.available() > 0) {
+      feed(link.read());
+    }
+  }
+
+  void feed(uint8_t data) {
+    if (decoder.idle() && data != FRAME_SYNC) {
+      // noise, or the rest of a frame that was dropped
+      dropped++;
+      return;
+    }
+    if (decoder.feed(data)) {
+      push(decoder.type(), decoder.payload(), decoder.length());
+    }
+  }
+
+  // takes the oldest message
+  /*
+  Takes in:   event (where to put it)
+
+  Returns:    false if there wasn't one
+  */
+  bool next(linkEvent &event) {
+    if (count == 0) {
+      return false;
+    }
+    event = queue[head];
+    head = (head + 1) % LINK_QUEUE_SIZE;
+    count--;
+    return true;
+  }
+
+  // throws away the messages nobody took
+  void discard() {
+    count = 0;
+  }
+
+  // diagnostics: garbled frames, bytes that weren't part of a message,
+  // and messages lost because the queue was full
+  uint16_t badFrames() const {
+    return decoder.errors();
+  }
+
+  uint16_t droppedBytes() const {
+    return dropped;
+  }
+
+  uint16_t overflows() const {
+    return overflowed;
+  }
+
+private:
+  FrameDecoder decoder;
+  linkEvent queue[LINK_QUEUE_SIZE];
+  // the oldest message, and how many there are
+  uint8_t head;
+  uint8_t count;
+  uint16_t dropped;
+  uint16_t overflowed;
+
+  void push(uint8_t type, const uint8_t *payload, uint8_t length) {
+    if (count == LINK_QUEUE_SIZE) {
+      overflowed++;
+      return;
+    }
+    linkEvent &event = queue[(head + count) % LINK_QUEUE_SIZE];
+    event.type = type;
+    event.length = length;
+    for (uint8_t i = 0; i < length; i++) {
+      event.payload[i] = payload[i];
+    }
+    count++;
+  }
+};
+
+/*
+  Holds the bytes going to the other board and hands them to the serial
+  port as it has room, so the sketch never waits for the link unless
+  more is queued than fits. pump() has to be called every so often
+  while there is something left to send, e.g. from the loops that wait
+  for touches or replies.
+
+  The 1.0 core can't say how much room the port has left
+  (availableForWrite came later), so the sender keeps its own count of
+  the bytes it gave the port and takes off one per 10 bit times at the
+  current rate.
+*/
+class LinkSender : public Print {
+public:
+  LinkSender(HardwareSerial &serial) : port(serial) {
+    head = 0;
+    count = 0;
+    speed = 0;
+    fallback = 0;
+    trial = false;
+    retried = 0;
+    unanswered = 0;
+    inPort = 0;
+    lastDrain = 0;
+  }
+
+  // queues a byte, only waits if the queue is full
+  size_t write(uint8_t data) {
+    while (count == LINK_TX_SIZE) {
+      pump();
+    }
+    queue[(head + count) % LINK_TX_SIZE] = data;
+    count++;
+    pump();
+    return 1;
+  }
+  using Print::write;
+
+  // moves as many bytes as the serial port has room for
+  void pump() {
+    drain();
+    //the port's buffer is a ring that holds one less than its size
+    while (count > 0 && inPort < LINK_PORT_BUFFER - 1) {
+      port.write(queue[head]);
+      head = (head + 1) % LINK_TX_SIZE;
+      count--;
+      inPort++;
+    }
+  }
+
+  // how many bytes haven't been given to the serial port yet
+  uint8_t pending() const {
+    return count;
+  }
+
+  // the rate the link runs at, an index into LINK_RATES
+  uint8_t rate() const {
+    return speed;
+  }
+
+  uint32_t baud() const {
+    return pgm_read_dword(&LINK_RATES[speed]);
+  }
+
+  // switches rate once everything queued has gone out at the old one
+  void setRate(uint8_t index) {
+    while (count > 0) {
+      pump();
+    }
+    port.flush();
+    inPort = 0;
+    port.end();
+    speed = index;
+    port.begin(baud());
+    trial = false;
+    unanswered = 0;
+  }
+
+  // switches to a rate the other board proposed, checkTrial() goes back
+  // if confirmRate() isn't called in time
+  void tryRate(uint8_t index) {
+    uint8_t previous = speed;
+    setRate(index);
+    fallback = previous;
+    trial = true;
+    trialStart = millis();
+  }
+
+  bool onTrial() const {
+    return trial;
+  }
+
+  void confirmRate() {
+    trial = false;
+  }
+
+  void checkTrial() {
+    if (trial && millis() - trialStart > LINK_TRIAL_TIME) {
+      setRate(fallback);
+    }
+  }
+
+  // boards that had to be sent again, in total and in a row without an
+  // answer
+  uint16_t retries() const {
+    return retried;
+  }
+
+  uint8_t unansweredInARow() const {
+    return unanswered;
+  }
+
+  void noteRetry(bool answered) {
+    retried++;
+    unanswered = answered ? 0 : unanswered + 1;
+  }
+
+  void noteAnswer() {
+    unanswered = 0;
+  }
+
+private:
+  HardwareSerial &port;
+  uint8_t queue[LINK_TX_SIZE];
+  uint8_t head;
+  uint8_t count;
+  uint8_t speed;
+  uint8_t fallback;
+  bool trial;
+  uint32_t trialStart;
+  uint16_t retried;
+  uint8_t unanswered;
+  //bytes given to the port that may not have gone out yet, as of
+  //lastDrain (micros)
+  uint8_t inPort;
+  uint32_t lastDrain;
+
+  // takes off the bytes the port has sent since the last call
+  void drain() {
+    uint32_t now = micros();
+    uint32_t elapsed = now - lastDrain;
+    //long enough for a full buffer at any rate, and the sum below
+    //can't overflow
+    if (inPort == 0 || elapsed > 100000) {
+      inPort = 0;
+      lastDrain = now;
+      return;
+    }
+    uint32_t sent = elapsed * (baud() / 10) / 1000000;
+    if (sent == 0) {
+      //keep the time so far for the next call
+      return;
+    }
+    inPort = sent >= inPort ? 0 : inPort - sent;
+    lastDrain = now;
+  }
+};
+
+// sends a small frame that is already in memory
+/*
+Takes in:   out (the link)
+            type (the frame type)
+            payload, length (what goes in it)
+
+Returns:    Nothing
+*/
+void sendFrame(LinkSender &out, uint8_t type, const uint8_t *payload, uint8_t length) {
+  FrameEncoder frame(out);
+  frame.begin(type, length);
+  for (uint8_t i = 0; i < length; i++) {
+    frame.put(payload[i]);
+  }
+  frame.end();
+}
+
+// sends a control frame, one with no payload
+/*
+Takes in:   out (the link)
+            type (FRAME_HELLO, FRAME_READY, BOARD_ACK or SNAPSHOT_REQUEST)
+
+Returns:    Nothing
+*/
+void sendControl(LinkSender &out, uint8_t type) {
+  sendFrame(out, type, NULL, 0);
+}
+
+// prints the link's rate, retries and error counts to the serial monitor
+/*
+Takes in:   link (the receiver to report on)
+            out (the sender to report on)
+
+Returns:    Nothing
+*/
+void reportLink(const LinkReceiver &link, const LinkSender &out) {
+  Serial.print("Link: ");
+  Serial.print(out.baud());
+  Serial.print(" baud, ");
+  Serial.print(out.retries());
+  Serial.print(" retries, ");
+  Serial.print(link.badFrames());
+  Serial.print(" bad frames, ");
+  Serial.print(link.droppedBytes());
+  Serial.print(" dropped bytes, ");
+  Serial.print(link.overflows());
+  Serial.println(" overflows");
+}
+
+// the territories the other board hasn't been sent yet, one bit per id
+class changeSet {
+public:
+  changeSet() {
+    bits = NULL;
+    bytes = 0;
+    all = false;
+  }
+
+  ~changeSet() {
+    delete[] bits;
+  }
+
+  // makes room for length territories, none of them changed
+  void begin(int length) {
+    delete[] bits;
+    bytes = (length + 7) / 8;
+    bits = new uint8_t[bytes];
+    clear();
+  }
+
+  void mark(uint8_t id) {
+    bits[id / 8] |= 1 << (id % 8);
+  }
+
+  // makes every territory count as changed, for a full snapshot
+  void markAll() {
+    all = true;
+  }
+
+  bool has(uint8_t id) const {
+    return all || (bits[id / 8] & (1 << (id % 8)));
+  }
+
+  // once the other board has the changes
+  void clear() {
+    for (int i = 0; i < bytes; i++) {
+      bits[i] = 0;
+    }
+    all = false;
+  }
+
+private:
+  uint8_t *bits;
+  int bytes;
+  bool all;
+};
+
+// puts a territory's record into a frame
+void putTerritory(FrameEncoder &frame, const territory &t)
+{
+  uint16_t packed = ((uint16_t) t.team << 14) | (t.power & 0x3FFF);
+  frame.put(t.id);
+  frame.put(packed >> 8);
+  frame.put(packed & 0xFF);
+}
+
+// updates a territory from its record
+/*
+Takes in:   gameMap (to move the territory between the teams)
+            allTerr (the territories)
+            length (how many there are)
+            record (TERRITORY_RECORD_SIZE bytes)
+
+Returns:    false if the record doesn't make sense for this map
+*/
+bool applyTerritory(masterMapGraph*& gameMap, territory*& allTerr, int length, const uint8_t *record)
+{
+  uint8_t id = record[0];
+  uint16_t packed = ((uint16_t) record[1] << 8) | record[2];
+  uint8_t team = packed >> 14;
+  // the power's sign bit is bit 13
+  int16_t power = (int16_t) (packed << 2) >> 2;
+  if (id >= length || team < 1 || team > 2) {
+    return false;
+  }
+
+  //changes a map node if it is different from what was recieved
+  allTerr[id].power = power;
+  if (allTerr[id].team != team)
+  {
+    allTerr[id].team = team;
+    gameMap->flip(allTerr[id]);
+  }
+  return true;
+}
+
+//the next message from the other board
+/*
+Takes in:   event (where to put it)
+            patience (how long to wait for it, in ms)
+
+Returns:    false if nothing came in time
+*/
+bool nextEvent(LinkReceiver &link, LinkSender &out, linkEvent &event, uint16_t patience)
+{
+    int32_t start = millis();
+    while ((millis() - start) <= patience)
+    {
+        out.pump();
+        link.poll(Serial3);
+        if (link.next(event))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+//the type of the next control frame from the other board, 0 if nothing
+//comes in a second (frames with a payload that come in meanwhile are
+//dropped)
+char readReply(LinkReceiver &link, LinkSender &out)
 {
+    linkEvent event;
     int32_t start = millis();
-    char current;
     while ((millis() - start) <= 1000)
     {
-        if (Serial3.available())
+        if (nextEvent(link, out, event, 1000) && event.length == 0)
         {
-            current = Serial3.read();
-            if (current == target)
-            {
-                return true;
-            }
-            else
+            return event.type;
+        }
+    }
+    return 0;
+}
+//wait for a control frame from the other board (used in send+wait)
+bool wait(char target, LinkReceiver &link, LinkSender &out)
+{
+    return readReply(link, out) == target;
+}
+//nothing came back, after a few times in a row the rate may be the
+//problem (e.g. the boards ended up at different ones)
+void noAnswer(LinkSender &out)
+{
+    out.noteRetry(false);
+    if (out.unansweredInARow() >= LINK_RETRY_LIMIT && out.rate() > 0)
+    {
+        out.setRate(out.rate() - 1);
+    }
+}
+//send FRAME_HELLO wait for FRAME_READY
+bool handshake(LinkReceiver &link, LinkSender &out)
+{
+    sendControl(out, FRAME_HELLO);
+    if (wait(FRAME_READY, link, out))
+    {
+        out.noteAnswer();
+        return true;
+    }
+    noAnswer(out);
+    return false;
+}
+//send the territories that changed
+void sendPoints(territory*& allTerr, int length, const changeSet &changes, LinkSender &out)
+{
+    FrameEncoder frame(out);
+    const int perFrame = FRAME_MAX_PAYLOAD / TERRITORY_RECORD_SIZE;
+    int sent = 0;
+    int next = 0;
+
+    while (true)
+    {
+        //the records for the next frame are the next perFrame changed ones
+        int count = 0;
+        int first = next;
+        for (; next < length && count < perFrame; ++next)
+        {
+            count += changes.has(next);
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        frame.begin(FRAME_TERRITORIES, count * TERRITORY_RECORD_SIZE);
+        for (int i = first; i < next; ++i)
+        {
+            if (changes.has(i))
             {
-                return false;
+                putTerritory(frame, allTerr[i]);
             }
         }
+        frame.end();
+        sent += count;
     }
-    return false;
+    frame.begin(FRAME_BOARD_END, 1);
+    frame.put(sent);
+    frame.end();
 }
-//send A wait for R
-bool handshake()
+//queue the changes for the other board, they go out while the caller
+//does other things until it checks boardTaken()
+void sendBoard(territory*& allTerr, int length, changeSet &changes, LinkReceiver &link, LinkSender &out)
 {
-    Serial3.print('A');
-    return wait('R');
+    //late answers to the handshake aren't the answer to this board
+    link.poll(Serial3);
+    link.discard();
+    sendPoints(allTerr, length, changes, out);
 }
-//send points
-void sendPoints(territory*& allTerr, int length)
+//wait for the other board to take the changes, they are kept until it
+//does
+bool boardTaken(changeSet &changes, LinkReceiver &link, LinkSender &out)
 {
-    Serial3.flush();
-    Serial3.println();
-    Serial3.print("B ");
-    for (int i = 0; i < length; ++i)
+    linkEvent event;
+    while (nextEvent(link, out, event, 1000))
     {
-        Serial3.print("T ");
-        Serial3.print(allTerr[i].id);
-        Serial3.print(' ');
-        Serial3.print(allTerr[i].power);
-        Serial3.print(' ');
-        Serial3.print(allTerr[i].team);
-        Serial3.print(' ');
-        Serial3.flush();
-    }
-}
-//recieve points
-bool recievePoints(masterMapGraph*& gameMap, territory*& allTerr, int length)
+        if (event.type == BOARD_ACK)
+        {
+            changes.clear();
+            out.noteAnswer();
+            return true;
+        }
+        if (event.type == SNAPSHOT_REQUEST)
+        {
+            changes.markAll();
+            out.noteRetry(true);
+            return false;
+        }
+        if (event.type == FRAME_RATE && event.length == 1 && event.payload[0] < LINK_RATE_COUNT)
+        {
+            //the other board got too many garbled frames and dropped a rate,
+            //everything goes again at the new one
+            out.setRate(event.payload[0]);
+            changes.markAll();
+            out.noteRetry(true);
+            return false;
+        }
+    }
+    noAnswer(out);
+    return false;
+}
+//find the fastest rate the test pattern gets through both ways at, the
+//other board answers from recievePoints (only player 1 calls this)
+uint8_t negotiateRate(LinkReceiver &link, LinkSender &out)
 {
-    //the current token recieved
-    String item;
-
-    int parameters[3];
-
-    while(!Serial3.available()) {}
+    linkEvent event;
+    uint8_t pattern[LINK_TEST_SIZE];
+    for (uint8_t i = 0; i < LINK_TEST_SIZE; ++i)
+    {
+        pattern[i] = testByte(i);
+    }
 
-    item = timedRead(1000);
-    //starting character
-    if (item != "B")
+    //waits for the other board to finish its setup and start listening
+    bool listening = false;
+    for (uint8_t tries = 0; !listening && tries < LINK_START_LIMIT; ++tries)
     {
-        Serial.println("Out of sync");
-        return false;
+        sendControl(out, FRAME_HELLO);
+        listening = wait(FRAME_READY, link, out);
     }
-    for (int i = 0; i < length; ++i)
+    if (!listening)
     {
-        while(!Serial3.available()) {}
-
-        item = timedRead(1000);
+        return 0;
+    }
 
-        if (item != "T")
+    for (uint8_t rate = LINK_RATE_COUNT - 1; rate > 0; --rate)
+    {
+        //asks a few times, the other board may still be starting up
+        bool answered = false;
+        for (uint8_t tries = 0; !answered && tries < LINK_PROPOSE_LIMIT; ++tries)
         {
-            return false;
+            sendFrame(out, FRAME_RATE, &rate, 1);
+            int32_t asked = millis();
+            while (!answered && (millis() - asked) <= 1000 && nextEvent(link, out, event, 1000))
+            {
+                answered = event.type == FRAME_RATE && event.length == 1 && event.payload[0] == rate;
+            }
+        }
+        if (!answered)
+        {
+            //it isn't listening, so stay at the base rate, it goes back
+            //there on its own if it switched and the answer got lost
+            out.setRate(0);
+            return 0;
         }
 
-        for (int j = 0; j < 3; ++j)
+        out.setRate(rate);
+        sendFrame(out, FRAME_TEST, pattern, LINK_TEST_SIZE);
+        bool echoed = false;
+        while (!echoed && nextEvent(link, out, event, 500))
+        {
+            echoed = event.type == FRAME_TEST && event.length == LINK_TEST_SIZE
+                && memcmp(event.payload, pattern, LINK_TEST_SIZE) == 0;
+        }
+        if (echoed)
         {
-            while(!Serial3.available()) {}
-            item = timedRead(1000);
+            sendFrame(out, FRAME_RATE, &rate, 1);
+            return rate;
+        }
 
-            parameters[j] = item.toInt();
-            Serial.println(item);
+        //waits until the other board has given up on this rate too
+        out.setRate(0);
+        out.noteRetry(false);
+        delay(LINK_TRIAL_TIME + 200);
+        link.poll(Serial3);
+        link.discard();
+    }
+    return 0;
+}
+//recieve points, handles what came in from the other board since the
+//last call and returns true once a whole board has been applied. Never
+//waits, so call it over and over while doing other things
+bool recievePoints(masterMapGraph*& gameMap, territory*& allTerr, int length, LinkReceiver &link, LinkSender &out)
+{
+    //records applied from the board that is coming in
+    static int records = 0;
+    static uint16_t badFrames = 0;
+    //garbled frames at the current rate
+    static uint16_t rateErrors = 0;
+    //when the last message came, and the garbage seen until then
+    static uint32_t lastHeard = 0;
+    static uint16_t noise = 0;
+    linkEvent event;
+
+    out.checkTrial();
+    out.pump();
+    link.poll(Serial3);
+    while (link.next(event))
+    {
+        lastHeard = millis();
+        noise = link.badFrames() + link.droppedBytes();
+        if (event.type == FRAME_HELLO)
+        {
+            //the other board is about to send
+            sendControl(out, FRAME_READY);
+        }
+        else if (event.type == FRAME_RATE && event.length == 1 && event.payload[0] < LINK_RATE_COUNT)
+        {
+            if (out.onTrial() && event.payload[0] == out.rate())
+            {
+                //player 1 got the test pattern back, the rate stays
+                out.confirmRate();
+            }
+            else
+            {
+                //answers at the old rate, then tries the new one
+                sendFrame(out, FRAME_RATE, event.payload, 1);
+                out.tryRate(event.payload[0]);
+                //anything else that was queued came at the old rate, e.g.
+                //the same proposal again
+                link.discard();
+                records = 0;
+                rateErrors = 0;
+                badFrames = link.badFrames();
+                return false;
+            }
+            rateErrors = 0;
+            badFrames = link.badFrames();
         }
-        //changes a map node if it is different from what was recieved
-        if (allTerr[i].power != parameters[1])
+        else if (event.type == FRAME_TEST)
         {
-            allTerr[i].power = parameters[1];
+            sendFrame(out, FRAME_TEST, event.payload, event.length);
         }
-        if (allTerr[i].team != parameters[2])
+        else if (event.type == FRAME_TERRITORIES)
         {
-            allTerr[i].team = parameters[2];
-            gameMap->flip(allTerr[i], allTerr);
+            for (int i = 0; i + TERRITORY_RECORD_SIZE <= event.length; i += TERRITORY_RECORD_SIZE)
+            {
+                if (applyTerritory(gameMap, allTerr, length, event.payload + i))
+                {
+                    records++;
+                }
+            }
+        }
+        else if (event.type == FRAME_BOARD_END)
+        {
+            //every record that was sent has to have come through, and
+            //no frame can have been lost
+            bool complete = event.length == 1 && event.payload[0] == records
+                && link.badFrames() == badFrames;
+            rateErrors += link.badFrames() - badFrames;
+            records = 0;
+            badFrames = link.badFrames();
+            if (!complete)
+            {
+                Serial.println("Out of sync");
+                if (rateErrors >= LINK_ERROR_LIMIT && out.rate() > 0)
+                {
+                    //too many garbled frames, both boards drop a rate
+                    uint8_t lower = out.rate() - 1;
+                    sendFrame(out, FRAME_RATE, &lower, 1);
+                    out.setRate(lower);
+                    rateErrors = 0;
+                }
+                else
+                {
+                    sendControl(out, SNAPSHOT_REQUEST);
+                }
+                continue;
+            }
+            sendControl(out, BOARD_ACK);
+            return true;
         }
     }
-    return true;
+
+    //nothing but garbage for a while, the other board may have dropped a
+    //rate without hearing back (a garbled board end), so follow it down
+    if (out.rate() > 0 && millis() - lastHeard > LINK_SILENCE_TIME
+        && (uint16_t) (link.badFrames() + link.droppedBytes() - noise) >= LINK_ERROR_LIMIT)
+    {
+        out.setRate(out.rate() - 1);
+        lastHeard = millis();
+        noise = link.badFrames() + link.droppedBytes();
+        records = 0;
+        rateErrors = 0;
+        badFrames = link.badFrames();
+    }
+    return false;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,443 @@
+#ifndef _DISPLAY_LIST_H
+#define _DISPLAY_LIST_H
+
+#include <Arduino.h>
+#include "tftStats.h"
+
+/*
+  Set DISPLAY_LIST to 1 to draw the side bar through a display list, so
+  redrawing it only sends what changed. It is off by default for its
+  RAM: two frames of DISPLAY_LIST_SIZE commands at 13 bytes each, 624
+  bytes of the Mega's 8K. The side bar records 18 commands.
+*/
+#ifndef DISPLAY_LIST
+#define DISPLAY_LIST 0
+#endif
+
+// how many commands fit in a frame, the rest of a frame with more is
+// sent straight to the screen
+#define DISPLAY_LIST_SIZE 24
+
+// what a command draws
+#define LIST_FILL   0
+#define LIST_LINE   1
+#define LIST_TEXT   2
+#define LIST_NUMBER 3
+#define LIST_RECT   4
+
+// one recorded drawing call
+struct listCommand {
+  uint8_t type : 3;
+  // text size
+  uint8_t scale : 5;
+  int16_t x, y;
+  // the size of a fill or rectangle, or the far end of a line
+  int16_t w, h;
+  uint16_t color;
+  // what text prints, the string has to stay around (a literal)
+  union {
+    const char *text;
+    int16_t number;
+  };
+};
+
+/*
+  Records the drawing calls of a frame instead of sending them, then
+  compares them to the last frame and only sends what changed.
+
+  Everything that changed (where it was drawn last frame and where it is
+  drawn now) is one damaged box. The new frame's fills are sent clipped
+  to that box and its lines and text are sent whole if they touch it,
+  in the order they were recorded. Lines and text can't be clipped, so
+  the box first grows to cover any that touch it. drawRect is sent as
+  its four sides, so it can be clipped like a fill.
+
+  A frame has to paint every pixel it owns, e.g. start with a background
+  fill, or whatever the last frame drew there won't be cleared.
+*/
+class DisplayList {
+public:
+  DisplayList(Display &screen) : display(screen) {
+    current = 0;
+    count[0] = 0;
+    count[1] = 0;
+    overflowed[0] = false;
+    overflowed[1] = false;
+    overflowCount = 0;
+    mostCommands = 0;
+    begin();
+  }
+
+  // starts recording a new frame
+  void begin() {
+    current ^= 1;
+    count[current] = 0;
+    overflowed[current] = false;
+    cursorX = 0;
+    cursorY = 0;
+    textScale = 1;
+    textColor = 0xFFFF;
+  }
+
+  // the same drawing calls as the display
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    listCommand c = command(LIST_FILL, x, y, color);
+    c.w = w;
+    c.h = h;
+    record(c);
+  }
+
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    listCommand c = command(LIST_RECT, x, y, color);
+    c.w = w;
+    c.h = h;
+    record(c);
+  }
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    listCommand c = command(LIST_LINE, x0, y0, color);
+    c.w = x1;
+    c.h = y1;
+    record(c);
+  }
+
+  void setCursor(int16_t x, int16_t y) {
+    cursorX = x;
+    cursorY = y;
+  }
+
+  void setTextSize(uint8_t s) {
+    textScale = s;
+  }
+
+  void setTextColor(uint16_t color) {
+    textColor = color;
+  }
+
+  void print(const char *text) {
+    listCommand c = command(LIST_TEXT, cursorX, cursorY, textColor);
+    c.text = text;
+    record(c);
+  }
+
+  void print(int number) {
+    listCommand c = command(LIST_NUMBER, cursorX, cursorY, textColor);
+    c.number = number;
+    record(c);
+  }
+
+  // the side bar always moves the cursor itself, so there is no next line
+  void println(const char *text) {
+    print(text);
+  }
+
+  void println(int number) {
+    print(number);
+  }
+
+  // sends the parts of the frame that changed since the last one
+  void flush() {
+    uint8_t previous = current ^ 1;
+    uint8_t longest = max(count[current], count[previous]);
+    Box damage = {0, 0, 0, 0};
+
+    // a frame that didn't fit has already been sent
+    if (overflowed[current]) {
+      return;
+    }
+    // the last frame didn't fit, so there is nothing to compare to
+    if (overflowed[previous]) {
+      replay();
+      return;
+    }
+    for (uint8_t i = 0; i < longest; i++) {
+      bool inOld = i < count[previous];
+      bool inNew = i < count[current];
+      if (inOld && inNew && same(frames[previous][i], frames[current][i])) {
+        continue;
+      }
+      if (inOld) {
+        grow(damage, bounds(frames[previous][i]));
+      }
+      if (inNew) {
+        grow(damage, bounds(frames[current][i]));
+      }
+    }
+    if (isEmpty(damage)) {
+      return;
+    }
+
+    // lines and text are sent whole, so whatever they touch is damaged too
+    bool grew = true;
+    while (grew) {
+      grew = false;
+      for (uint8_t i = 0; i < count[current]; i++) {
+        listCommand &c = frames[current][i];
+        Box box = bounds(c);
+        bool clipped = c.type == LIST_FILL || c.type == LIST_RECT;
+        if (!clipped && overlaps(box, damage) && !inside(box, damage)) {
+          grow(damage, box);
+          grew = true;
+        }
+      }
+    }
+
+    for (uint8_t i = 0; i < count[current]; i++) {
+      listCommand &c = frames[current][i];
+      if (overlaps(bounds(c), damage)) {
+        send(c, damage);
+      }
+    }
+  }
+
+  // sends the whole frame that was recorded, whatever the last one was
+  void replay() {
+    for (uint8_t i = 0; i < count[current]; i++) {
+      send(frames[current][i], everything());
+    }
+  }
+
+  // how many frames had more commands than fit, since the start
+  unsigned int overflows() const {
+    return overflowCount;
+  }
+
+  // the most commands a frame has recorded (up to DISPLAY_LIST_SIZE)
+  uint8_t mostRecorded() const {
+    return mostCommands;
+  }
+
+  // prints the frame one command per line, so it can be replayed elsewhere
+  /*
+  Takes in:   out (where to print it, e.g. Serial)
+
+  Returns:    Nothing
+  */
+  void trace(Print &out) {
+    for (uint8_t i = 0; i < count[current]; i++) {
+      listCommand &c = frames[current][i];
+      switch (c.type) {
+        case LIST_FILL: out.print("fillRect ");
+          break;
+        case LIST_LINE: out.print("drawLine ");
+          break;
+        case LIST_RECT: out.print("drawRect ");
+          break;
+        default: out.print("text ");
+          break;
+      }
+      out.print(c.x);
+      out.print(' ');
+      out.print(c.y);
+      out.print(' ');
+      if (c.type == LIST_FILL || c.type == LIST_LINE || c.type == LIST_RECT) {
+        out.print(c.w);
+        out.print(' ');
+        out.print(c.h);
+        out.print(' ');
+      }
+      else {
+        out.print(c.scale);
+        out.print(' ');
+      }
+      out.print(c.color, HEX);
+      if (c.type == LIST_TEXT) {
+        out.print(' ');
+        out.print(c.text);
+      }
+      else if (c.type == LIST_NUMBER) {
+        out.print(' ');
+        out.print(c.number);
+      }
+      out.println();
+    }
+  }
+
+private:
+  // a box from (left, top) up to but not including (right, bottom)
+  struct Box {
+    int16_t left, top, right, bottom;
+  };
+
+  Display &display;
+  listCommand frames[2][DISPLAY_LIST_SIZE];
+  // how many commands were recorded in each frame
+  uint8_t count[2];
+  // if a frame had more commands than fit, and went straight to the screen
+  bool overflowed[2];
+  unsigned int overflowCount;
+  uint8_t mostCommands;
+  // which frame is being recorded
+  uint8_t current;
+  int16_t cursorX, cursorY;
+  uint8_t textScale;
+  uint16_t textColor;
+
+  listCommand command(uint8_t type, int16_t x, int16_t y, uint16_t color) {
+    listCommand c;
+    c.type = type;
+    c.scale = textScale;
+    c.x = x;
+    c.y = y;
+    c.w = 0;
+    c.h = 0;
+    c.color = color;
+    c.text = NULL;
+    return c;
+  }
+
+  // adds a command to the frame, once the frame is full the commands so
+  // far and everything after them are sent as they come
+  void record(const listCommand &c) {
+    if (!overflowed[current] && count[current] < DISPLAY_LIST_SIZE) {
+      frames[current][count[current]++] = c;
+      mostCommands = max(mostCommands, count[current]);
+      return;
+    }
+    if (!overflowed[current]) {
+      overflowed[current] = true;
+      overflowCount++;
+      replay();
+    }
+    send(c, everything());
+  }
+
+  static bool same(const listCommand &a, const listCommand &b) {
+    if (a.type != b.type || a.scale != b.scale || a.x != b.x || a.y != b.y
+        || a.w != b.w || a.h != b.h || a.color != b.color) {
+      return false;
+    }
+    if (a.type == LIST_TEXT) {
+      return a.text == b.text;
+    }
+    return a.type != LIST_NUMBER || a.number == b.number;
+  }
+
+  // where a command draws
+  static Box bounds(const listCommand &c) {
+    Box box;
+    box.left = c.x;
+    box.top = c.y;
+    switch (c.type) {
+      case LIST_FILL:
+      case LIST_RECT:
+        box.right = c.x + c.w;
+        box.bottom = c.y + c.h;
+        break;
+      case LIST_LINE:
+        box.left = min(c.x, c.w);
+        box.top = min(c.y, c.h);
+        box.right = max(c.x, c.w) + 1;
+        box.bottom = max(c.y, c.h) + 1;
+        break;
+      default:
+        // classic font characters are 6x8 at text size 1
+        box.right = c.x + 6 * c.scale * characters(c);
+        box.bottom = c.y + 8 * c.scale;
+        break;
+    }
+    return box;
+  }
+
+  static uint8_t characters(const listCommand &c) {
+    if (c.type == LIST_TEXT) {
+      return strlen(c.text);
+    }
+    uint8_t digits = c.number < 0 ? 2 : 1;
+    for (int16_t n = c.number / 10; n != 0; n /= 10) {
+      digits++;
+    }
+    return digits;
+  }
+
+  static Box everything() {
+    Box box = {-32768, -32768, 32767, 32767};
+    return box;
+  }
+
+  static bool isEmpty(const Box &box) {
+    return box.right <= box.left || box.bottom <= box.top;
+  }
+
+  static bool overlaps(const Box &a, const Box &b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+  }
+
+  static bool inside(const Box &a, const Box &b) {
+    return a.left >= b.left && a.right <= b.right && a.top >= b.top && a.bottom <= b.bottom;
+  }
+
+  // makes a box big enough to also cover another
+  static void grow(Box &box, const Box &other) {
+    if (isEmpty(other)) {
+      return;
+    }
+    if (isEmpty(box)) {
+      box = other;
+      return;
+    }
+    box.left = min(box.left, other.left);
+    box.top = min(box.top, other.top);
+    box.right = max(box.right, other.right);
+    box.bottom = max(box.bottom, other.bottom);
+  }
+
+  // sends a fill cut down to the damaged box
+  void sendFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, const Box &damage) {
+    int16_t left = max(x, damage.left);
+    int16_t top = max(y, damage.top);
+    int16_t right = min((int16_t) (x + w), damage.right);
+    int16_t bottom = min((int16_t) (y + h), damage.bottom);
+    if (right > left && bottom > top) {
+      display.fillRect(left, top, right - left, bottom - top, color);
+    }
+  }
+
+  // sends one command, fills and rectangles are cut down to the damaged box
+  void send(const listCommand &c, const Box &damage) {
+    switch (c.type) {
+      case LIST_FILL:
+        sendFill(c.x, c.y, c.w, c.h, c.color, damage);
+        break;
+      case LIST_RECT:
+        sendFill(c.x, c.y, c.w, 1, c.color, damage);
+        sendFill(c.x, c.y + c.h - 1, c.w, 1, c.color, damage);
+        sendFill(c.x, c.y + 1, 1, c.h - 2, c.color, damage);
+        sendFill(c.x + c.w - 1, c.y + 1, 1, c.h - 2, c.color, damage);
+        break;
+      case LIST_LINE:
+        display.drawLine(c.x, c.y, c.w, c.h, c.color);
+        break;
+      default:
+        display.setTextSize(c.scale);
+        display.setTextColor(c.color);
+        display.setCursor(c.x, c.y);
+        if (c.type == LIST_TEXT) {
+          display.print(c.text);
+        }
+        else {
+          display.print(c.number);
+        }
+        break;
+    }
+  }
+};
+
+// prints how full the display list has been and how often a frame
+// didn't fit, to the serial monitor
+/*
+Takes in:   list (the display list to report on)
+
+Returns:    Nothing
+*/
+void reportDisplayList(const DisplayList &list) {
+  Serial.print("Display list: ");
+  Serial.print(list.mostRecorded());
+  Serial.print(" of ");
+  Serial.print(DISPLAY_LIST_SIZE);
+  Serial.print(" commands used, ");
+  Serial.print(list.overflows());
+  Serial.println(" overflows");
+}
+
+#endif
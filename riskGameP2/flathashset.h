@@ -0,0 +1,228 @@
+#ifndef _FLAT_HASH_SET_H_
+#define _FLAT_HASH_SET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "linkedlist.h"
+
+// the table grows once it is more than MAX_LOAD_NUM/MAX_LOAD_DEN full,
+// so there is always an empty slot to end a probe
+#define MAX_LOAD_NUM 3
+#define MAX_LOAD_DEN 4
+
+// An iterator, same idea as HashTableIterator but it only needs the slot.
+template <typename T>
+struct FlatHashSetIterator {
+  unsigned int slot;
+  const T *entry;
+
+  T item() const {
+    return *entry;
+  }
+};
+
+/*
+  A hash set stored in one contiguous array using open addressing with
+  linear probing. Same contract as HashTable: T needs a hash() method
+  and the != operator.
+
+  Inserting never allocates per item, the table only reallocates when
+  it passes the load factor above, and removing shifts the following
+  items back so no tombstones are needed.
+*/
+template <typename T>
+class FlatHashSet {
+public:
+  typedef FlatHashSetIterator<T> Iterator;
+
+  // creates an empty set that holds the given number of items without
+  // growing, like HashTable's tableSize (the slots are rounded up to a
+  // power of two that keeps them under the load factor)
+  // pool is only there to match HashTable, the slots are already one block
+  FlatHashSet(unsigned int items = 4, NodePool<T> *pool = NULL) {
+    capacity = 1;
+    while (capacity * MAX_LOAD_NUM < items * MAX_LOAD_DEN) {
+      capacity *= 2;
+    }
+    allocate(capacity);
+    numItems = 0;
+  }
+
+  ~FlatHashSet() {
+    delete[] slots;
+    delete[] used;
+  }
+
+  // Check if the item already appears in the set.
+  bool contains(const T& item) const;
+
+  // Insert the item, do nothing if it is already in the set.
+  // Returns true iff the insertion was successful (i.e. the item was not there).
+  bool insert(const T& item);
+
+  // Removes the item, does nothing if it is not in the set.
+  void remove(const T& item);
+
+  // Returns the number of items held in the set.
+  unsigned int size() const { return numItems; }
+
+  // Get the iterator for the first item.
+  Iterator startIterator() const;
+
+  // Advance the iterator (returns the next iterator).
+  Iterator nextIterator(const Iterator& iter) const;
+
+  // Test if a given iterator is the end iterator.
+  bool isEndIterator(const Iterator& iter) const;
+
+private:
+  T *slots;
+  // one bit per slot, set if the slot holds an item
+  uint8_t *used;
+  unsigned int numItems, capacity;
+
+  void allocate(unsigned int tableSize) {
+    slots = new T[tableSize];
+    used = new uint8_t[(tableSize + 7) / 8];
+    for (unsigned int i = 0; i < (tableSize + 7) / 8; i++) {
+      used[i] = 0;
+    }
+  }
+
+  bool isUsed(unsigned int slot) const {
+    return used[slot / 8] & (1 << (slot % 8));
+  }
+
+  void setUsed(unsigned int slot, bool value) {
+    if (value) {
+      used[slot / 8] |= 1 << (slot % 8);
+    }
+    else {
+      used[slot / 8] &= ~(1 << (slot % 8));
+    }
+  }
+
+  // The slot the item would like to live in.
+  unsigned int home(const T& item) const {
+    return item.hash() & (capacity - 1);
+  }
+
+  // Probes from the item's home slot, returns the slot holding the item
+  // or the empty slot where it would be inserted.
+  unsigned int findSlot(const T& item) const;
+
+  // Moves every item into a table of the new size.
+  void resize(unsigned int newCapacity);
+};
+
+template <typename T>
+unsigned int FlatHashSet<T>::findSlot(const T& item) const {
+  unsigned int slot = home(item);
+  while (isUsed(slot) && slots[slot] != item) {
+    slot = (slot + 1) & (capacity - 1);
+  }
+  return slot;
+}
+
+template <typename T>
+bool FlatHashSet<T>::contains(const T& item) const {
+  return isUsed(findSlot(item));
+}
+
+template <typename T>
+bool FlatHashSet<T>::insert(const T& item) {
+  // grow first if one more item would pass the load factor
+  if ((numItems + 1) * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM) {
+    resize(capacity * 2);
+  }
+
+  unsigned int slot = findSlot(item);
+  if (isUsed(slot)) {
+    // the item was already in the set
+    return false;
+  }
+
+  slots[slot] = item;
+  setUsed(slot, true);
+  numItems++;
+  return true;
+}
+
+template <typename T>
+void FlatHashSet<T>::remove(const T& item) {
+  unsigned int hole = findSlot(item);
+  if (!isUsed(hole)) {
+    return;
+  }
+  setUsed(hole, false);
+  numItems--;
+
+  // shift back any later item in the same run whose home slot is not
+  // between the hole and where it sits now, so lookups still find it
+  unsigned int next = (hole + 1) & (capacity - 1);
+  while (isUsed(next)) {
+    unsigned int want = home(slots[next]);
+    bool stays;
+    if (hole <= next) {
+      stays = (hole < want && want <= next);
+    }
+    else {
+      stays = (hole < want || want <= next);
+    }
+
+    if (!stays) {
+      slots[hole] = slots[next];
+      setUsed(hole, true);
+      setUsed(next, false);
+      hole = next;
+    }
+    next = (next + 1) & (capacity - 1);
+  }
+}
+
+template <typename T>
+FlatHashSetIterator<T> FlatHashSet<T>::startIterator() const {
+  Iterator iter;
+  // find the first used slot (capacity marks the end)
+  for (iter.slot = 0; iter.slot < capacity && !isUsed(iter.slot); iter.slot++);
+  iter.entry = (iter.slot < capacity) ? &slots[iter.slot] : NULL;
+  return iter;
+}
+
+template <typename T>
+FlatHashSetIterator<T> FlatHashSet<T>::nextIterator(const Iterator& iter) const {
+  Iterator next;
+  for (next.slot = iter.slot + 1; next.slot < capacity && !isUsed(next.slot); next.slot++);
+  next.entry = (next.slot < capacity) ? &slots[next.slot] : NULL;
+  return next;
+}
+
+template <typename T>
+bool FlatHashSet<T>::isEndIterator(const Iterator& iter) const {
+  return (iter.slot >= capacity);
+}
+
+template <typename T>
+void FlatHashSet<T>::resize(unsigned int newCapacity) {
+  T *oldSlots = slots;
+  uint8_t *oldUsed = used;
+  unsigned int oldCapacity = capacity;
+
+  capacity = newCapacity;
+  allocate(capacity);
+
+  // reinsert everything, the new table is empty so nothing can collide
+  // with an existing copy of the item
+  for (unsigned int i = 0; i < oldCapacity; i++) {
+    if (oldUsed[i / 8] & (1 << (i % 8))) {
+      unsigned int slot = findSlot(oldSlots[i]);
+      slots[slot] = oldSlots[i];
+      setUsed(slot, true);
+    }
+  }
+
+  delete[] oldSlots;
+  delete[] oldUsed;
+}
+
+#endif
@@ -40,13 +40,17 @@ struct HashTableIterator {
 template <typename T>
 class HashTable {
 public:
+  typedef HashTableIterator<T> Iterator;
+
   // creates an empty hash table of the given size.
-  // If no parameter is given then it is default to 10.
-  HashTable(unsigned int tableSize = 4) {
+  // If no parameter is given then it is default to 4.
+  // If a pool is given every bucket takes its nodes from it.
+  HashTable(unsigned int tableSize = 4, NodePool<T> *pool = NULL) {
     // This will ensure valid tablesize if given.
     //assert(tableSize > 0);
     // Makes the table.
-    table = new LinkedList<T>[tableSize];
+    this->pool = pool;
+    table = newBuckets(tableSize);
     //assert(table != NULL);
 
     this->tableSize = tableSize;
@@ -84,10 +88,18 @@ public:
 
 private:
   LinkedList<T> *table;
-  LinkedList<T> *temptable;
-  HashTableIterator<T> *starting;
+  NodePool<T> *pool;
   unsigned int numItems, tableSize;
 
+  // Makes an array of empty buckets that use the table's pool.
+  LinkedList<T>* newBuckets(unsigned int amount) {
+    LinkedList<T> *buckets = new LinkedList<T>[amount];
+    for (unsigned int i = 0; i < amount; i++) {
+      buckets[i].setPool(pool);
+    }
+    return buckets;
+  }
+
   // Computes which hash table bucket the item maps to.
   unsigned int getBucket(const T& item) const {
     return item.hash() % tableSize;
@@ -173,24 +185,14 @@ bool HashTable<T>::isEndIterator(const HashTableIterator<T>& iter) const {
 template <typename T>
 void HashTable<T>::resize() {
   // Creates a temporary table which will be double the size of the old table.
-  temptable = new LinkedList<T>[tableSize * 2];
-  // This will mark the starting iterator.
-  *starting = startIterator();
-  // This will be a variable which determines the new buckets.
-  unsigned int newbucket;
-  // For loop will determine the new buckets for each iterator and then insert
+  LinkedList<T> *temptable = newBuckets(tableSize * 2);
+  // For loop will determine the new buckets for each item and then insert
   // them into the temptable.
-  for (unsigned int i = 0; i < size(); i++) {
-    // Gets the new bucket.
-    newbucket = getnewBucket(starting->item());
-    // Inserts the item from the old table into the new based off bucket
-    // location.
-    temptable[newbucket].insertFront(starting->item());
-    // This will mark the next interator.
-    *starting = nextIterator(*starting);
+  for (HashTableIterator<T> iter = startIterator(); !isEndIterator(iter); iter = nextIterator(iter)) {
+    temptable[getnewBucket(iter.item())].insertFront(iter.item());
   }
-  // This will delete the old HashTable.
-  HashTable<T>::~HashTable();
+  // This will delete the old buckets.
+  delete[] table;
   // Doubles the tableSize
   tableSize *= 2;
   // Copies data from the temptable into the table variable.
@@ -12,6 +12,11 @@ using namespace std;
 // struct for holding an item and pointers to the next and previous node
 template <typename T>
 struct ListNode {
+  // constructor for nodes that are filled in later (used by NodePool)
+  ListNode() {
+    prev = next = NULL;
+  }
+
   // constructor
   ListNode(const T& item, ListNode<T> *prev = NULL, ListNode<T> *next = NULL) {
     this->item = item;
@@ -23,13 +28,85 @@ struct ListNode {
   ListNode<T> *next, *prev;
 };
 
+/*
+  A fixed capacity arena of list nodes. Every node lives in one block
+  and the free ones are chained through their next pointers, so taking
+  or returning a node is O(1), never touches the heap, and the whole
+  arena is freed with a single delete.
+
+  Lists fall back to new/delete once the pool is exhausted.
+*/
+template <typename T>
+class NodePool {
+public:
+  NodePool(unsigned int capacity) {
+    block = new ListNode<T>[capacity];
+    this->capacity = capacity;
+    numUsed = peakUsed = 0;
+
+    // chain every node onto the free list
+    freeList = NULL;
+    for (unsigned int i = capacity; i > 0; i--) {
+      block[i - 1].next = freeList;
+      freeList = &block[i - 1];
+    }
+  }
+
+  ~NodePool() {
+    delete[] block;
+  }
+
+  // Returns a node holding item, or NULL if the pool is empty.
+  ListNode<T>* allocate(const T& item, ListNode<T> *prev, ListNode<T> *next) {
+    ListNode<T> *node = freeList;
+    if (node == NULL) {
+      return NULL;
+    }
+    freeList = node->next;
+
+    node->item = item;
+    node->prev = prev;
+    node->next = next;
+
+    numUsed++;
+    if (numUsed > peakUsed) {
+      peakUsed = numUsed;
+    }
+    return node;
+  }
+
+  // Puts a node from this pool back on the free list.
+  void release(ListNode<T> *node) {
+    node->next = freeList;
+    freeList = node;
+    numUsed--;
+  }
+
+  // True iff the node was handed out by this pool.
+  bool owns(const ListNode<T> *node) const {
+    return node >= block && node < block + capacity;
+  }
+
+  // usage counters, for reporting
+  unsigned int size() const { return capacity; }
+  unsigned int used() const { return numUsed; }
+  unsigned int peak() const { return peakUsed; }
+
+private:
+  ListNode<T> *block;
+  ListNode<T> *freeList;
+  unsigned int capacity, numUsed, peakUsed;
+};
+
 // A linked list, just as discussed in the slides.
+// If a NodePool is given the nodes are taken from it instead of the heap.
 template <typename T>
 class LinkedList {
 public:
-  LinkedList() {
+  LinkedList(NodePool<T> *pool = NULL) {
     first = last = NULL;
     listSize = 0;
+    this->pool = pool;
   }
 
   ~LinkedList() {
@@ -63,16 +140,43 @@ public:
   // Returns the NULL pointer if the item is not in the list.
   ListNode<T>* find(const T& item) const;
 
+  // Sets the pool new nodes come from, for lists made with new[].
+  // Only call this while the list is empty.
+  void setPool(NodePool<T> *pool) { this->pool = pool; }
+
 private:
   ListNode<T> *first, *last;
   unsigned int listSize;
+  NodePool<T> *pool;
+
+  // get a node from the pool if there is one with room, otherwise the heap
+  ListNode<T>* newNode(const T& item, ListNode<T> *prev, ListNode<T> *next) {
+    ListNode<T> *node = NULL;
+    if (pool != NULL) {
+      node = pool->allocate(item, prev, next);
+    }
+    if (node == NULL) {
+      node = new ListNode<T>(item, prev, next);
+    }
+    return node;
+  }
+
+  // hand a node back to wherever it came from
+  void deleteNode(ListNode<T> *node) {
+    if (pool != NULL && pool->owns(node)) {
+      pool->release(node);
+    }
+    else {
+      delete node;
+    }
+  }
 };
 
 template <typename T>
 void LinkedList<T>::insertFront(const T& item) {
   // get a new ListNode to hold the item
   // it points back to NULL and ahead to the first node in current list
-  ListNode<T> *node = new ListNode<T>(item, NULL, first);
+  ListNode<T> *node = newNode(item, NULL, first);
   //assert(node != NULL);
 
   // if the list is not empty, have the first node point back to the new node.
@@ -94,7 +198,7 @@ template <typename T>
 void LinkedList<T>::insertBack(const T& item) {
   // similar to insertFront
 
-  ListNode<T> *node = new ListNode<T>(item, last, NULL);
+  ListNode<T> *node = newNode(item, last, NULL);
   //assert(node != NULL);
 
   if (last != NULL) {
@@ -117,7 +221,7 @@ void LinkedList<T>::insertBefore(const T& item, ListNode<T> *link) {
   }
 
   // get a new node to hold this item
-  ListNode<T> *node = new ListNode<T>(item, link->prev, link);
+  ListNode<T> *node = newNode(item, link->prev, link);
   //assert(node != NULL);
 
   // redirect surrounding links, the order you do this is important!
@@ -145,7 +249,7 @@ void LinkedList<T>::removeFront() {
   // works even if the list had size 1
   first = first->next;
 
-  delete toDelete;
+  deleteNode(toDelete);
   listSize--;
 }
 
@@ -168,7 +272,7 @@ void LinkedList<T>::removeBack() {
   // works even if the list had size 1
   last = last->prev;
 
-  delete toDelete;
+  deleteNode(toDelete);
   listSize--;
 }
 
@@ -190,7 +294,7 @@ void LinkedList<T>::removeNode(ListNode<T>* node) {
   node->prev->next = node->next;
   node->next->prev = node->prev;
 
-  delete node;
+  deleteNode(node);
   listSize--;
 }
 
@@ -2,28 +2,100 @@
 #define _MAP_GRAPH_H_
 
 #include "hashtable.h"
-#include "dynarray.h"
+#include "flathashset.h"
 #include <Arduino.h>
+#ifdef MAP_IN_FLASH
+#include "mapData.h"
+#endif
 
 using namespace std;
-//struct that represents a node
+#ifdef MAP_IN_FLASH
+//struct that represents a node, only the parts that change during a game
+//are kept in RAM, everything else is read from mapData.h
 struct territory
 {
-    //coordinates of the territory
-    int x;
-    int y;
     //unique ID of node
-    int id;
-    int team;
+    uint8_t id;
+    //team 1 or 2
+    uint8_t team;
+    //army power invested in tile, signed since battles can overshoot zero
+    int16_t power;
+};
+#else
+//struct that represents a node, packed into 8 bytes
+//(x and y < 4096 leave room for maps many screens wide and tall)
+struct territory
+{
+    //coordinates of the territory
+    uint16_t x : 12;
     //The continent it's a part of
-    int cont;
+    uint16_t cont : 3;
+    uint16_t y : 12;
     //if it is special type of tile
-    int type;
+    uint16_t type : 3;
+    //unique ID of node
+    uint8_t id;
+    //team 1 or 2
+    uint8_t team : 2;
     //the strength of specialness
-    int magnitude;
-    //army power invested in tile
-    int power;
+    uint8_t magnitude : 6;
+    //army power invested in tile, signed since battles can overshoot zero
+    int16_t power;
 };
+#endif
+
+//every territory of the loaded map, indexed by id (defined in risk.cpp)
+extern territory* territories;
+
+//the parts of a territory that never change, read through these so the
+//callers don't care if they live in territories[] or in flash
+uint16_t terrX(uint8_t id)
+{
+#ifdef MAP_IN_FLASH
+    return pgm_read_word(&MAP_INFO[id].x);
+#else
+    return territories[id].x;
+#endif
+}
+
+uint16_t terrY(uint8_t id)
+{
+#ifdef MAP_IN_FLASH
+    return pgm_read_word(&MAP_INFO[id].y);
+#else
+    return territories[id].y;
+#endif
+}
+
+//The continent it's a part of
+uint8_t terrCont(uint8_t id)
+{
+#ifdef MAP_IN_FLASH
+    return pgm_read_byte(&MAP_INFO[id].cont);
+#else
+    return territories[id].cont;
+#endif
+}
+
+//if it is special type of tile
+uint8_t terrType(uint8_t id)
+{
+#ifdef MAP_IN_FLASH
+    return pgm_read_byte(&MAP_INFO[id].type);
+#else
+    return territories[id].type;
+#endif
+}
+
+//the strength of specialness
+uint8_t terrMagnitude(uint8_t id)
+{
+#ifdef MAP_IN_FLASH
+    return pgm_read_byte(&MAP_INFO[id].magnitude);
+#else
+    return territories[id].magnitude;
+#endif
+}
 
 //wrapper for int that allows it to be hashed
 struct IntWrapper {
@@ -43,47 +115,92 @@ struct IntWrapper {
     return val != rhs.val;
   }
 };
+// which structure holds the map topology once the map is loaded
+//   ADJ_HASH   - one HashTable of neighbours per territory (mutable)
+//   ADJ_CSR    - one offsets array and one packed neighbour array (read only)
+//   ADJ_BITSET - an N*N bit matrix, one bit test per lookup (read only)
+#define ADJ_HASH 0
+#define ADJ_CSR 1
+#define ADJ_BITSET 2
+
+#ifndef MAP_ADJACENCY
+#define MAP_ADJACENCY ADJ_CSR
+#endif
+
+#if defined(MAP_IN_FLASH) && MAP_ADJACENCY != ADJ_CSR
+#error "MAP_IN_FLASH keeps the roads as CSR rows, it needs MAP_ADJACENCY ADJ_CSR"
+#endif
+
 /*
   Represents a graph using an adjacency list representation.
   Vertices are assumed to be integers.
+  Set is the container holding each vertex's neighbours, HashTable or
+  FlatHashSet of IntWrapper.
 */
+template <typename Set = HashTable<IntWrapper> >
 class mapGraph {
 public:
+  typedef typename Set::Iterator NeighbourIterator;
+
   // No constructor or destructor are necessary this time.
   // A new instance will be an empty graph with no nodes.
-  mapGraph(uint8_t nodes) {
+  // If a pool is given the neighbour sets take their list nodes from it.
+  // Without sets the graph only keeps its node count, for a subclass
+  // that stores the roads some other way (nothing may be added then).
+  mapGraph(uint8_t nodes, NodePool<IntWrapper> *pool = NULL, bool sets = true) {
     count = nodes;
-    nbrs = new HashTable<IntWrapper>*[nodes];
-    for (int i = 0; i < nodes; ++i)
+    this->pool = pool;
+    nbrs = NULL;
+    if (sets)
     {
-        nbrs[i] = NULL;
+      nbrs = new Set*[nodes];
+      for (int i = 0; i < nodes; ++i)
+      {
+          nbrs[i] = NULL;
+      }
     }
   }
 
   ~mapGraph() {
     //deallocate all the memory
+    clear();
+    delete[] nbrs;
+  }
+
+  // removes every vertex and edge, keeping the node count
+  void clear()
+  {
+    if (nbrs == NULL)
+    {
+      return;
+    }
     for (int i = 0; i < count; ++i)
     {
       delete nbrs[i];
+      nbrs[i] = NULL;
     }
-    delete[] nbrs;
   }
-  // add a vertex
-  void addVertex(territory t)
+  // sets the pool used by vertices added from now on
+  void setPool(NodePool<IntWrapper> *pool)
+  {
+    this->pool = pool;
+  }
+
+  // add a vertex with room for the expected number of neighbours
+  void addVertex(uint8_t t, unsigned int expected = 4)
   {
-    if (nbrs[t.id] == NULL)
+    if (nbrs[t] == NULL)
     {
-      nbrs[t.id] = new HashTable<IntWrapper>;
+      nbrs[t] = new Set(max(expected, 1u), pool);
     }
   }
 
-  // adds an edge, creating the vertices if they do not exist
+  // adds an edge, both vertices must already be in the graph
   // if the edge already existed, does nothing
-  void addEdge(territory t, territory destination)
+  void addEdge(uint8_t t, uint8_t destination)
   {
-    addVertex(destination);
-    nbrs[t.id]->insert(*(new IntWrapper(destination.id)));
-    nbrs[destination.id]->insert(*(new IntWrapper(t.id)));
+    nbrs[t]->insert(IntWrapper(destination));
+    nbrs[destination]->insert(IntWrapper(t));
   }
   //removes and edge if it exists
   void removeEdge(uint8_t t, uint8_t destination)
@@ -117,19 +234,19 @@ public:
   }
 
   // returns a const iterator to the neighbours of v
-  HashTableIterator<IntWrapper> neighbours(const uint8_t& t) const
+  NeighbourIterator neighbours(const uint8_t& t) const
   {
     return nbrs[t]->startIterator();
   }
 
   // returns a const iterator to the neighbours of v
-  HashTableIterator<IntWrapper> nextNeighbour(const uint8_t& t, const HashTableIterator<IntWrapper>& iter) const
+  NeighbourIterator nextNeighbour(const uint8_t& t, const NeighbourIterator& iter) const
   {
     return nbrs[t]->nextIterator(iter);
   }
 
   // returns a const iterator to the end of v's neighour set
-  bool isLastNeighbour(const uint8_t& t, const HashTableIterator<IntWrapper>& iter) const
+  bool isLastNeighbour(const uint8_t& t, const NeighbourIterator& iter) const
   {
     return nbrs[t]->isEndIterator(iter);
   }
@@ -158,142 +275,637 @@ public:
 private:
   //a counter for how many nodes there are
   uint8_t count;
-  //a storage for the neighbours for all the nodes
-  HashTable<IntWrapper> **nbrs;
+  //a storage for the neighbours for all the nodes (NULL without sets)
+  Set **nbrs;
+  //where the neighbour sets get their list nodes (NULL for the heap)
+  NodePool<IntWrapper> *pool;
 };
 
+// the set type used by the game's graphs while they are mutable
+// define MAP_FLAT_SETS to store neighbours in open addressing FlatHashSets
+#ifdef MAP_FLAT_SETS
+typedef FlatHashSet<IntWrapper> NeighbourSet;
+#else
+typedef HashTable<IntWrapper> NeighbourSet;
+#endif
 
-class masterMapGraph : public mapGraph
-{
+
+// iterator over the packed neighbour list of one vertex
+struct CSRIterator {
+  const uint8_t *node;
+
+  IntWrapper item() const {
+#ifdef MAP_IN_FLASH
+    return IntWrapper(pgm_read_byte(node));
+#else
+    return IntWrapper(*node);
+#endif
+  }
+};
+
+/*
+  Read only compressed sparse row graph. The neighbours of vertex t are
+  adj[offsets[t]] to adj[offsets[t+1] - 1], so the whole topology lives
+  in two allocations instead of one HashTable per vertex.
+
+  It is built in two passes: the constructor sizes every row from the
+  degrees counted beforehand, addEdge fills the rows and finish() drops
+  the room left over by duplicate edges.
+
+  With MAP_IN_FLASH the rows are the MAP_OFFSETS and MAP_ROADS tables of
+  mapData.h and are read straight out of flash instead.
+*/
+class CSRGraph {
 public:
-  masterMapGraph(uint8_t nodes, uint8_t conts) : mapGraph(nodes)
+#ifdef MAP_IN_FLASH
+  // wraps rows that are already laid out in flash
+  CSRGraph(uint8_t nodes, const uint16_t *flashOffsets, const uint8_t *flashRoads)
   {
-    //initialize all the data storage elements
-    teamMap = new mapGraph(nodes);
-    team1Amt = 0;
-    team2Amt = 0;
+    count = nodes;
+    offsets = flashOffsets;
+    adj = flashRoads;
+  }
 
-    //initialize continent containers
-    this->conts = conts;
-    allConts = new DynamicArray<uint8_t>*[conts];
-    contAmts = new int[conts];
-    for (int i = 0; i < conts; ++i)
+  // the rows belong to the flash tables, nothing to free or tidy up
+  void finish()
+  {
+  }
+#else
+  // allocates rows for the given number of neighbours of each vertex
+  CSRGraph(uint8_t nodes, const uint8_t *degree)
+  {
+    count = nodes;
+    offsets = new uint16_t[count + 1];
+
+    //prefix sums of the degrees give each row's start
+    offsets[0] = 0;
+    for (int i = 0; i < count; ++i)
     {
-      allConts[i] = NULL;
-      contAmts[i] = 0;
+      offsets[i + 1] = offsets[i] + degree[i];
+    }
+
+    adj = new uint8_t[offsets[count]];
+    //how much of each row is filled, only needed while building
+    filled = new uint8_t[count];
+    for (int i = 0; i < count; ++i)
+    {
+      filled[i] = 0;
     }
-    //wheat bonus initialization(special tile)
-    wheatbonus[0] = 0;
-    wheatbonus[1] = 0;
   }
-  ~masterMapGraph()
+
+  ~CSRGraph()
   {
-    //free up all the memory
-    for (int i = 0; i < conts; ++i)
+    delete[] offsets;
+    delete[] adj;
+    delete[] filled;
+  }
+
+  // adds an undirected edge, if the edge already existed, does nothing
+  void addEdge(uint8_t t, uint8_t destination)
+  {
+    if (isNeighbour(t, destination))
     {
-      delete allConts[i];
+      return;
+    }
+    adj[offsets[t] + filled[t]++] = destination;
+    if (t != destination)
+    {
+      adj[offsets[destination] + filled[destination]++] = t;
     }
-    delete[] contAmts;
-    delete[] teamMap;
-    delete[] allConts;
   }
-  //adds a vertex to all relavant containers
-  void addVertex(territory t)
+
+  // closes up the gaps left by duplicate edges once every edge is added
+  void finish()
   {
-    //add to team map
-    teamMap->addVertex(t);
-    if (!isVertex(t.id))
+    if (filled == NULL)
     {
-      if (t.team == 1)
+      return;
+    }
+    uint16_t end = 0;
+    for (int i = 0; i < count; ++i)
+    {
+      uint16_t start = offsets[i];
+      offsets[i] = end;
+      for (uint8_t j = 0; j < filled[i]; ++j)
       {
-        team1Amt++;
-        Serial.print("BLUE TERR ADDED ");
-        Serial.println(team1Amt);
+        adj[end++] = adj[start + j];
       }
-      else
+    }
+    offsets[count] = end;
+    delete[] filled;
+    filled = NULL;
+  }
+#endif
+
+  // returns an iterator to the first neighbour of t
+  CSRIterator neighbours(const uint8_t& t) const
+  {
+    CSRIterator iter;
+    iter.node = adj + rowStart(t);
+    return iter;
+  }
+
+  // returns an iterator to the neighbour after iter
+  CSRIterator nextNeighbour(const uint8_t& t, const CSRIterator& iter) const
+  {
+    CSRIterator next;
+    next.node = iter.node + 1;
+    return next;
+  }
+
+  // returns true once iter has walked past t's last neighbour
+  bool isLastNeighbour(const uint8_t& t, const CSRIterator& iter) const
+  {
+    return iter.node == adj + rowStart(t + 1);
+  }
+
+  // return the number of neighbours of t
+  uint8_t numNeighbours(uint8_t t) const
+  {
+    return rowStart(t + 1) - rowStart(t);
+  }
+
+  //checks if a node is a neighbour, rows are short so a scan is enough
+  bool isNeighbour(uint8_t from, uint8_t to) const
+  {
+#ifdef MAP_IN_FLASH
+    uint16_t end = rowStart(from + 1);
+#else
+    uint16_t end = (filled == NULL) ? offsets[from + 1] : offsets[from] + filled[from];
+#endif
+    for (uint16_t i = rowStart(from); i < end; ++i)
+    {
+      if (road(i) == to)
       {
-        team2Amt++;
-        Serial.print("RED TERR ADDED ");
-        Serial.println(team2Amt);
+        return true;
       }
-      //wheat bonus
-      if (t.type == 4)
+    }
+    return false;
+  }
+
+private:
+  //a counter for how many nodes there are
+  uint8_t count;
+#ifdef MAP_IN_FLASH
+  //the rows in flash, laid out the same as below
+  const uint16_t *offsets;
+  const uint8_t *adj;
+
+  uint16_t rowStart(uint8_t t) const
+  {
+    return pgm_read_word(&offsets[t]);
+  }
+
+  uint8_t road(uint16_t i) const
+  {
+    return pgm_read_byte(&adj[i]);
+  }
+#else
+  //start of each vertex's row in adj, with one extra entry for the end
+  uint16_t *offsets;
+  //every neighbour list, back to back
+  uint8_t *adj;
+  //entries added to each row so far (NULL once finished)
+  uint8_t *filled;
+
+  uint16_t rowStart(uint8_t t) const
+  {
+    return offsets[t];
+  }
+
+  uint8_t road(uint16_t i) const
+  {
+    return adj[i];
+  }
+#endif
+};
+
+// counts the set bits in a mask of the given number of bytes
+uint8_t countBits(const uint8_t *mask, uint8_t bytes)
+{
+  uint8_t amount = 0;
+  for (uint8_t i = 0; i < bytes; ++i)
+  {
+    for (uint8_t byte = mask[i]; byte != 0; byte &= byte - 1)
+    {
+      amount++;
+    }
+  }
+  return amount;
+}
+
+// iterator over the set bits of one row of a BitGraph
+struct BitIterator {
+  uint8_t node;
+
+  IntWrapper item() const {
+    return IntWrapper(node);
+  }
+};
+
+/*
+  Read only adjacency matrix packed one bit per pair of territories.
+  Row t holds bit u iff (t,u) is an edge, so a lookup is a single bit
+  test and a whole row can be ANDed with a mask of territories. Takes
+  N*N/8 bytes, which only suits small maps (32 bytes for 16 territories).
+*/
+class BitGraph {
+public:
+  // allocates an empty matrix, the degrees are not needed
+  BitGraph(uint8_t nodes, const uint8_t *degree = NULL)
+  {
+    count = nodes;
+    rowBytes = (count + 7) / 8;
+    bits = new uint8_t[count * rowBytes];
+    for (uint16_t i = 0; i < count * rowBytes; ++i)
+    {
+      bits[i] = 0;
+    }
+  }
+
+  ~BitGraph()
+  {
+    delete[] bits;
+  }
+
+  // adds an undirected edge
+  void addEdge(uint8_t t, uint8_t destination)
+  {
+    bits[t * rowBytes + destination / 8] |= 1 << (destination % 8);
+    bits[destination * rowBytes + t / 8] |= 1 << (t % 8);
+  }
+
+  // nothing to tidy up, here so both read only graphs build the same way
+  void finish()
+  {
+  }
+
+  // returns an iterator to the first neighbour of t
+  BitIterator neighbours(const uint8_t& t) const
+  {
+    BitIterator iter;
+    iter.node = firstFrom(t, 0);
+    return iter;
+  }
+
+  // returns an iterator to the neighbour after iter
+  BitIterator nextNeighbour(const uint8_t& t, const BitIterator& iter) const
+  {
+    BitIterator next;
+    next.node = firstFrom(t, iter.node + 1);
+    return next;
+  }
+
+  // the end of every row is marked by node == count
+  bool isLastNeighbour(const uint8_t& t, const BitIterator& iter) const
+  {
+    return iter.node == count;
+  }
+
+  // return the number of neighbours of t
+  uint8_t numNeighbours(uint8_t t) const
+  {
+    return countBits(row(t), rowBytes);
+  }
+
+  //checks if a node is a neighbour
+  bool isNeighbour(uint8_t from, uint8_t to) const
+  {
+    return bits[from * rowBytes + to / 8] & (1 << (to % 8));
+  }
+
+  // the neighbours of t as a bitmask of rowBytes bytes, bit u is territory u
+  const uint8_t* row(uint8_t t) const
+  {
+    return bits + t * rowBytes;
+  }
+
+  // number of bytes in one row
+  uint8_t maskBytes() const
+  {
+    return rowBytes;
+  }
+
+private:
+  //a counter for how many nodes there are
+  uint8_t count;
+  //bytes per row of the matrix
+  uint8_t rowBytes;
+  //the matrix, row by row
+  uint8_t *bits;
+
+  // finds the first neighbour of t at or after start (count if none)
+  uint8_t firstFrom(uint8_t t, uint16_t start) const
+  {
+    const uint8_t *r = row(t);
+    for (uint16_t u = start; u < count; ++u)
+    {
+      //skip over empty bytes a whole byte at a time
+      if (u % 8 == 0 && r[u / 8] == 0)
       {
-        wheatbonus[t.team-1] += t.magnitude;
-        Serial.println("Wheat");
-        Serial.println(t.id);
+        u += 7;
+        continue;
       }
+      if (r[u / 8] & (1 << (u % 8)))
+      {
+        return u;
+      }
+    }
+    return count;
+  }
+};
+
+
+class masterMapGraph : public mapGraph<NeighbourSet>
+{
+public:
+  typedef mapGraph<NeighbourSet> baseGraph;
+
+  //the hash sets are only made for ADJ_HASH, the other backends keep
+  //the roads in packed (a CSRGraph or BitGraph) instead
+  masterMapGraph(uint8_t nodes, uint8_t conts, uint16_t edges = 0)
+    : baseGraph(nodes, NULL, MAP_ADJACENCY == ADJ_HASH)
+  {
+    //one arena for the edges if the map is kept in hash tables,
+    //two nodes per edge
+    edgePool = NULL;
+    if (edges > 0 && MAP_ADJACENCY == ADJ_HASH)
+    {
+      edgePool = new NodePool<IntWrapper>(2 * edges);
     }
-    //add to contienent list
-    if (allConts[t.cont] == NULL)
+    setPool(edgePool);
+
+    //one bit per territory for each team, all clear until addVertex
+    teamBytes = (nodes + 7) / 8;
+    teamBits[0] = new uint8_t[teamBytes];
+    teamBits[1] = new uint8_t[teamBytes];
+    for (int i = 0; i < teamBytes; ++i)
     {
-      allConts[t.cont] = new DynamicArray<uint8_t>;
-      allConts[t.cont]->pushBack(t.id);
-      contAmts[t.cont]++;
+      teamBits[0][i] = 0;
+      teamBits[1][i] = 0;
     }
-    else if (!mapGraph::isVertex(t.id))
+
+    //initialize continent counters
+    this->conts = conts;
+    contAmts = new uint8_t[conts];
+    contOwned[0] = new uint8_t[conts];
+    contOwned[1] = new uint8_t[conts];
+    for (int i = 0; i < conts; ++i)
     {
-      allConts[t.cont]->pushBack(t.id);
-      contAmts[t.cont]++;
+      contAmts[i] = 0;
+      contOwned[0][i] = 0;
+      contOwned[1][i] = 0;
     }
-    //add it to the main map
-    mapGraph::addVertex(t);
+    //wheat bonus initialization(special tile)
+    wheatbonus[0] = 0;
+    wheatbonus[1] = 0;
+#if MAP_ADJACENCY != ADJ_HASH
+    packed = NULL;
+#endif
+    roadsVersion = 0;
+  }
+  ~masterMapGraph()
+  {
+    //free up all the memory
+    delete[] contAmts;
+    delete[] contOwned[0];
+    delete[] contOwned[1];
+    delete[] teamBits[0];
+    delete[] teamBits[1];
+#if MAP_ADJACENCY != ADJ_HASH
+    delete packed;
+#endif
+    //the edges have to go back to the pool before it is freed
+    baseGraph::clear();
+    delete edgePool;
+  }
+
+  //changes whenever a road is added, so anything built from the roads
+  //can tell when it is out of date
+  uint16_t topologyVersion() const
+  {
+    return roadsVersion;
+  }
+
+  //the arena holding the graph edges (NULL if the edge count was unknown)
+  const NodePool<IntWrapper>* nodePool() const
+  {
+    return edgePool;
   }
 
-  //add an edge to all relavant maps
-  void addEdge(territory t, territory destination)
+#if MAP_ADJACENCY == ADJ_CSR
+  typedef CSRGraph PackedGraph;
+  typedef CSRIterator NeighbourIterator;
+#elif MAP_ADJACENCY == ADJ_BITSET
+  typedef BitGraph PackedGraph;
+  typedef BitIterator NeighbourIterator;
+#else
+  typedef baseGraph::NeighbourIterator NeighbourIterator;
+#endif
+
+  //first pass of the builder: allocates all the neighbour storage once
+  //the number of roads at each territory (degree[id]) has been counted
+  //(the flash build reads its rows from mapData.h and takes NULL)
+  void reserve(const uint8_t *degree)
   {
-    addVertex(destination);
-    if (t.team == destination.team)
+#if MAP_ADJACENCY == ADJ_HASH
+    for (int i = 0; i < size(); ++i)
     {
-      teamMap->addEdge(t, destination);
+      baseGraph::addVertex(i, degree[i]);
     }
-    mapGraph::addEdge(t, destination);
+#endif
+#if defined(MAP_IN_FLASH)
+    packed = new PackedGraph(size(), MAP_OFFSETS, MAP_ROADS);
+#elif MAP_ADJACENCY != ADJ_HASH
+    packed = new PackedGraph(size(), degree);
+#endif
+  }
+
+  //freezes the topology once every edge is added
+  void compact()
+  {
+#if MAP_ADJACENCY != ADJ_HASH
+    packed->finish();
+#endif
+  }
+
+  // returns an iterator to the neighbours of t
+  NeighbourIterator neighbours(const uint8_t& t) const
+  {
+#if MAP_ADJACENCY != ADJ_HASH
+    return packed->neighbours(t);
+#else
+    return baseGraph::neighbours(t);
+#endif
+  }
+
+  // advances an iterator over the neighbours of t
+  NeighbourIterator nextNeighbour(const uint8_t& t, const NeighbourIterator& iter) const
+  {
+#if MAP_ADJACENCY != ADJ_HASH
+    return packed->nextNeighbour(t, iter);
+#else
+    return baseGraph::nextNeighbour(t, iter);
+#endif
+  }
+
+  // returns true once iter is past t's last neighbour
+  bool isLastNeighbour(const uint8_t& t, const NeighbourIterator& iter) const
+  {
+#if MAP_ADJACENCY != ADJ_HASH
+    return packed->isLastNeighbour(t, iter);
+#else
+    return baseGraph::isLastNeighbour(t, iter);
+#endif
+  }
+
+  // return the number of neighbours of t
+  uint8_t numNeighbours(uint8_t t)
+  {
+#if MAP_ADJACENCY != ADJ_HASH
+    return packed->numNeighbours(t);
+#else
+    return baseGraph::numNeighbours(t);
+#endif
   }
 
-  //filp a territory in the team map
-  void flip(territory t, territory* allTerr)
+  //checks of a node is a neighbour
+  bool isNeighbour(uint8_t from, uint8_t to)
+  {
+#if MAP_ADJACENCY != ADJ_HASH
+    return packed->isNeighbour(from, to);
+#else
+    return baseGraph::isNeighbour(from, to);
+#endif
+  }
+  //records a territory in the team boards and continent counts
+  //call once per territory, the neighbour storage comes from reserve()
+  //(a team other than 1 or 2 leaves it with no owner)
+  void addVertex(const territory& t)
   {
-    //update team counts
-    if (t.team == 1)
+    //count it in its contienent
+    uint8_t cont = terrCont(t.id);
+    contAmts[cont]++;
+    if (!isTeam(t.team))
     {
-      team1Amt++;
-      team2Amt--;
+      return;
     }
-    else
+    teamBits[t.team-1][t.id / 8] |= 1 << (t.id % 8);
+    //wheat bonus
+    if (terrType(t.id) == 4)
     {
-      team2Amt++;
-      team1Amt--;
+      wheatbonus[t.team-1] += terrMagnitude(t.id);
     }
-    Serial.print("-------------------");
-    Serial.println(team1Amt);
+    contOwned[t.team-1][cont]++;
+  }
+
+  //add an edge to the map, after reserve()
+  void addEdge(const territory& t, const territory& destination)
+  {
+    roadsVersion++;
+#if defined(MAP_IN_FLASH)
+    //the roads are already in flash
+#elif MAP_ADJACENCY != ADJ_HASH
+    packed->addEdge(t.id, destination.id);
+#else
+    baseGraph::addEdge(t.id, destination.id);
+#endif
+  }
 
-    if (t.type == 4)
+  //filp a territory between the teams, t.team has to be the new owner
+  //(1 or 2, anything else changes nothing)
+  //returns the contienent the new owner just completed, or -1
+  int flip(const territory& t)
+  {
+    uint8_t bit = 1 << (t.id % 8);
+    if (!isTeam(t.team) || (teamBits[t.team-1][t.id / 8] & bit))
     {
-      wheatbonus[t.team-1] -= t.magnitude;
-      wheatbonus[t.team] += t.magnitude;
+      return -1;
     }
-    //flip all neighbours in team map
-    for (HashTableIterator<IntWrapper> i = neighbours(t.id); !isLastNeighbour(t.id, i); i = nextNeighbour(t.id, i))
+    uint8_t owner = t.team - 1;
+    uint8_t previous = 1 - owner;
+    //a territory the map left with no owner isn't on either board
+    bool owned = teamBits[previous][t.id / 8] & bit;
+
+    teamBits[owner][t.id / 8] |= bit;
+    teamBits[previous][t.id / 8] &= ~bit;
+
+    uint8_t cont = terrCont(t.id);
+    if (owned)
     {
-      if (teamMap->isEdge(t.id, i.item().val))
+      contOwned[previous][cont]--;
+      if (terrType(t.id) == 4)
       {
-        teamMap->removeEdge(t.id, i.item().val);
+        wheatbonus[previous] -= terrMagnitude(t.id);
       }
-      else
+    }
+    if (terrType(t.id) == 4)
+    {
+      wheatbonus[owner] += terrMagnitude(t.id);
+    }
+    //count it in the contienent for its new owner
+    contOwned[owner][cont]++;
+
+    if (contOwned[owner][cont] == contAmts[cont])
+    {
+      return cont;
+    }
+    return -1;
+  }
+
+  //the territories a team owns, bit t of byte t/8 is territory t
+  const uint8_t* teamMask(int team) const
+  {
+    return teamBits[team-1];
+  }
+
+  //checks if a team owns a territory
+  bool owns(int team, uint8_t t) const
+  {
+    return teamBits[team-1][t / 8] & (1 << (t % 8));
+  }
+
+  //how many territories a team owns
+  uint8_t territoriesOwned(int team) const
+  {
+    return countBits(teamBits[team-1], teamBytes);
+  }
+
+  //how many of t's neighbours belong to the other team
+  uint8_t enemyNeighbours(uint8_t t) const
+  {
+    const uint8_t *enemy = owns(1, t) ? teamBits[1] : teamBits[0];
+#if MAP_ADJACENCY == ADJ_BITSET
+    //the row and the board line up byte for byte
+    uint8_t amount = 0;
+    const uint8_t *adj = packed->row(t);
+    for (uint8_t i = 0; i < teamBytes; ++i)
+    {
+      uint8_t both = adj[i] & enemy[i];
+      amount += countBits(&both, 1);
+    }
+    return amount;
+#else
+    uint8_t amount = 0;
+    for (NeighbourIterator i = neighbours(t); !isLastNeighbour(t, i); i = nextNeighbour(t, i))
+    {
+      uint8_t u = i.item().val;
+      if (enemy[u / 8] & (1 << (u % 8)))
       {
-        teamMap->addEdge(t, allTerr[i.item().val]);
+        amount++;
       }
     }
+    return amount;
+#endif
   }
 
   int winner()
   {
-    if (team1Amt == 0)
+    if (territoriesOwned(1) == 0)
     {
       return 2;
     }
-    else if (team2Amt == 0)
+    else if (territoriesOwned(2) == 0)
     {
       return 1;
     }
@@ -302,19 +914,17 @@ public:
       return -1;
     }
   }
-  //calculate continent bonus
-  int continentBonus(int team, territory*& allTerr)
+
+  //calculate continent bonus: one army per territory in every
+  //contienent the team owns completely, plus its wheat bonus
+  int continentBonus(int team)
   {
-    int bonus = size() + wheatbonus[team-1];
+    int bonus = wheatbonus[team-1];
     for (int i = 0; i < conts; ++i)
     {
-      for (int j = 0; j < contAmts[i]; ++j)
+      if (contOwned[team-1][i] == contAmts[i])
       {
-        if (allTerr[allConts[i]->getItem(j)].team != team)
-        {
-          bonus -= contAmts[i];
-          break;
-        }
+        bonus += contAmts[i];
       }
     }
     return bonus;
@@ -323,14 +933,27 @@ public:
 private:
   //a count of contienents
   uint8_t conts;
-  //storage for important maps
-  mapGraph *teamMap;
-  int team1Amt;
-  int team2Amt;
-  //2D array of all contienents and the territories in them
-  DynamicArray<uint8_t> **allConts;
-  int* contAmts;
+
+  //only teams 1 and 2 have boards and counts
+  static bool isTeam(uint8_t team)
+  {
+    return team == 1 || team == 2;
+  }
+
+  NodePool<IntWrapper> *edgePool;
+  //one bitboard per team, territory t is bit t
+  uint8_t *teamBits[2];
+  uint8_t teamBytes;
+  uint16_t roadsVersion;
+  //how many territories each contienent has, and how many of them
+  //each team owns (kept up to date by addVertex and flip)
+  uint8_t *contAmts;
+  uint8_t *contOwned[2];
   int wheatbonus[2];
+#if MAP_ADJACENCY != ADJ_HASH
+  //packed topology, built by compact()
+  PackedGraph *packed;
+#endif
 };
 
 #endif
\ No newline at end of file
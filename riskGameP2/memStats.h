@@ -0,0 +1,102 @@
+#ifndef _MEM_STATS_H
+#define _MEM_STATS_H
+
+#include <Arduino.h>
+#include "linkedlist.h"
+
+#ifdef __AVR__
+// avr-libc malloc internals: the end of the heap and its list of free chunks
+struct __freelist {
+  size_t sz;
+  struct __freelist *nx;
+};
+extern char *__brkval;
+extern char __heap_start;
+extern struct __freelist *__flp;
+#endif
+
+// a snapshot of the heap
+struct heapStats {
+  //bytes between the top of the heap and the stack
+  unsigned int gap;
+  //bytes sitting in freed chunks inside the heap
+  unsigned int freeListed;
+  //how many freed chunks there are, and the biggest one
+  unsigned int freeBlocks;
+  unsigned int largestBlock;
+};
+
+// walks malloc's free list to see how much free memory is stuck in holes
+/*
+Returns:    the current heapStats (all zero when not running on AVR)
+*/
+heapStats readHeap() {
+  heapStats stats = {0, 0, 0, 0};
+#ifdef __AVR__
+  char top;
+  char *heapEnd = (__brkval == NULL) ? &__heap_start : __brkval;
+  stats.gap = &top - heapEnd;
+
+  for (struct __freelist *chunk = __flp; chunk != NULL; chunk = chunk->nx) {
+    // every chunk also carries a size_t header that malloc can reuse
+    unsigned int size = chunk->sz + sizeof(size_t);
+    stats.freeListed += size;
+    stats.freeBlocks++;
+    if (size > stats.largestBlock) {
+      stats.largestBlock = size;
+    }
+  }
+#endif
+  return stats;
+}
+
+// prints a heap snapshot to the serial monitor
+/*
+Takes in:   label (printed in front of the numbers)
+
+Returns:    Nothing
+*/
+void reportHeap(const char *label) {
+  heapStats stats = readHeap();
+  unsigned int freeBytes = stats.gap + stats.freeListed;
+  // fragmentation: share of the free memory that a single allocation can't use
+  unsigned int largest = max(stats.gap, stats.largestBlock);
+  unsigned int fragmentation = (freeBytes == 0) ? 0 : 100 - (100UL * largest) / freeBytes;
+
+  Serial.print(label);
+  Serial.print(": free ");
+  Serial.print(freeBytes);
+  Serial.print(" (gap ");
+  Serial.print(stats.gap);
+  Serial.print(", ");
+  Serial.print(stats.freeBlocks);
+  Serial.print(" holes with ");
+  Serial.print(stats.freeListed);
+  Serial.print(") fragmentation ");
+  Serial.print(fragmentation);
+  Serial.println("%");
+}
+
+// prints how much of a node pool is in use
+/*
+Takes in:   label (printed in front of the numbers)
+            pool (the pool to report on, may be NULL)
+
+Returns:    Nothing
+*/
+template <typename T>
+void reportPool(const char *label, const NodePool<T> *pool) {
+  Serial.print(label);
+  if (pool == NULL) {
+    Serial.println(": no pool");
+    return;
+  }
+  Serial.print(": ");
+  Serial.print(pool->used());
+  Serial.print('/');
+  Serial.print(pool->size());
+  Serial.print(" nodes, peak ");
+  Serial.println(pool->peak());
+}
+
+#endif
@@ -4,6 +4,14 @@
 #include <TouchScreen.h>
 #include "readFile.h"
 #include "comm.h"
+#include "memStats.h"
+#include "tftStats.h"
+#include "viewport.h"
+#include "roadCache.h"
+#include "touchGrid.h"
+#include "digitFont.h"
+#include "starfield.h"
+#include "displayList.h"
 //#include "draw.h"
 //#include "globalData.h"
 
@@ -20,6 +28,12 @@
 #define JOY_HORIZ_ANALOG A0
 #define JOY_SEL 2
 
+// build with JOYSTICK 0 if there is no joystick, its pins are never read
+// then. Unwired analog pins float and would pan the camera on their own
+#ifndef JOYSTICK
+#define JOYSTICK 1
+#endif
+
 // width/height of the display when rotated horizontally
 #define TFT_WIDTH 320
 #define TFT_HEIGHT 240
@@ -33,6 +47,11 @@
 #define JOY_DEADZONE 64
 #define JOY_CENTRE 512
 #define JOY_STEPS_PER_PIXEL 64
+// how many pixels the camera pans per joystick step
+#define JOY_PAN_SPEED 4
+// how many readings in a row have to be centred at startup for the
+// joystick to be used
+#define JOY_CHECKS 8
 
 // touch screen pins, obtained from the documentaion
 #define YP A2  // must be an analog pin, use "An" notation!
@@ -48,18 +67,19 @@
 #define TS_MAXY 940
 
 // defines the player color for player 1 and player 2
-// and the dimensions of a territory
+// and the dimensions of a territory and its continent border
 #define P1Color 0x001F  //****************
 #define P2Color 0xF800  //****************
 #define terrWidth 25    //****************
 #define terrHeight 25   //****************
+#define contWidth 5
 
 // thresholds to determine if there was a touch
 #define MINPRESSURE   10
 #define MAXPRESSURE 1000
 
 // Use hardware SPI (on Mega2560, #52, #51, and #50) and the above for CS/DC
-Adafruit_ILI9341 tft = Adafruit_ILI9341(TFT_CS, TFT_DC);
+Display tft = Display(TFT_CS, TFT_DC);
 
 // a multimeter reading says there are 300 ohms of resistance across the plate,
 // so initialize with this to get more accurate readings
@@ -67,31 +87,65 @@ TouchScreen ts = TouchScreen(XP, YP, XM, YM, 300);
 
 /***********************************************************************************/
 
-uint8_t PAGENUMBER = 1;
+// the map coordinate shown in the top left corner of the map area
+int16_t cameraX = 0;
+int16_t cameraY = 0;
+// how far the territories reach, the camera stops there
+int16_t mapWidth = DISP_WIDTH;
+int16_t mapHeight = DISP_HEIGHT;
 uint8_t NUM_TERR;
 territory* territories;
 
+// territories whose tile has to be redrawn, one bit per id
+uint8_t* dirty;
+// territories that changed since the other board last got them
+changeSet unsynced;
+// what has come in from the other board, and what is going out to it
+LinkReceiver incoming;
+LinkSender outgoing(Serial3);
+// what the side bar was last drawn for
+int sideBarPlayer = 0;
+bool sideBarScrollsRight = true;
+// the armies left to place, shown in the side bar (-1 when not placing)
+int armiesLeft = -1;
+// with DISPLAY_LIST the side bar is drawn through a display list, so
+// redrawing it only sends what changed
+#if DISPLAY_LIST
+DisplayList panel(tft);
+#else
+Display &panel = tft;
+#endif
+// the roads in the last two views, clipped and in screen coordinates,
+// so going back to the previous screen doesn't have to clip them again
+roadCache viewRoads[2];
+uint8_t newestRoads = 0;
+// the territory picked to attack from, outlined in white (-1 if none)
+int selectedID = -1;
+// true if the joystick read centred at startup, it pans the camera only then
+bool joystickFound = false;
+
 /***********************************************************************************/
 
-// gets the coordinates of the users touch
+// the part of the map on screen
 /*
-Takes in:   touch_x (x coordinate of users touch)
-            touch_y (y coordinate of users touch)
-
-Returns:  Nothing
+Returns:    the viewport at the camera
 */
-void getTouch(int16_t &touch_x, int16_t &touch_y) {
-    TSPoint touch;
-    do {
-        touch = ts.getPoint();                
-    } while(touch.z < MINPRESSURE or touch.z > MAXPRESSURE);
+viewport currentView() {
+    viewport view;
+    view.left = cameraX;
+    view.top = cameraY;
+    view.width = DISP_WIDTH;
+    view.height = DISP_HEIGHT;
+    return view;
+}
 
-    // maps touch to screen
-    touch_x = map(touch.y, TS_MINY, TS_MAXY, TFT_WIDTH - 1, 0) - 20;
-    touch_y = map(touch.x, TS_MINX, TS_MAXX, 0, TFT_HEIGHT - 1); 
+// how far right/down the camera can go before it runs off the map
+int16_t maxCameraX() {
+    return mapWidth > DISP_WIDTH ? mapWidth - DISP_WIDTH : 0;
+}
 
-    // small delay so touches don't spam
-    delay(100);
+int16_t maxCameraY() {
+    return mapHeight > DISP_HEIGHT ? mapHeight - DISP_HEIGHT : 0;
 }
 
 // draws the powers for each territory
@@ -103,117 +157,147 @@ Returns:    Nothing
 */
 void drawPowers(int player, int id) {
     // prints the number of armies in that territory, adjusts depending on how many armies are there
-    tft.setTextSize(3);
-    tft.setTextColor(0xFFFF);
-    uint16_t shift = (PAGENUMBER - 1) * DISP_WIDTH;
+    uint16_t color = 0xFFFF;
 
     // changes the color if it is a special territory
-    switch(territories[id].type) {
+    switch(terrType(id)) {
         // 1: fire, 2: dam, 3: fort, 4: fertile land
-        case 1: tft.setTextColor(0xFCC6);   //orange
+        case 1: color = 0xFCC6;   //orange
             break;
-        case 2: tft.setTextColor(0x07FF);   // blue
+        case 2: color = 0x07FF;   // blue
             break;
-        case 3: tft.setTextColor(0x8430);   // grey
+        case 3: color = 0x8430;   // grey
             break;
-        case 4: tft.setTextColor(0xFFED);   // yellow
+        case 4: color = 0xFFED;   // yellow
             break;
     }
 
-    // only print numbers if they are on page 1 (omit page 2)
-    if (PAGENUMBER == 1 and territories[id].x <= DISP_WIDTH) {
-        tft.setCursor((territories[id].x + 4), (territories[id].y + 2));
-        // change text size and cursor location if there are more than 10 armies
-        if (territories[id].power >= 10) {
-            tft.setTextSize(2);
-            tft.setCursor((territories[id].x + 1), (territories[id].y + 5));
-        }
-        tft.println(territories[id].power);
+    // only print numbers on territories that are all the way on screen,
+    // so they don't spill into the side bar
+    viewport view = currentView();
+    if (!view.contains(terrX(id), terrY(id)) or !view.contains(terrX(id) + terrWidth - 1, terrY(id) + terrHeight - 1)) {
+        return;
     }
 
-    // only print numbers if they are on page 2 (omit page 1)
-    else if (PAGENUMBER == 2 and territories[id].x >= DISP_WIDTH) {
-        tft.setCursor((territories[id].x + 4) % DISP_WIDTH, (territories[id].y + 2));
-        // change text size and cursor location if there are more than 10 armies    
-        if (territories[id].power >= 10) {
-            tft.setTextSize(2);
-            tft.setCursor((territories[id].x - shift + 1), (territories[id].y + 5));
-        }
-        tft.println(territories[id].power);    
+    int16_t x = terrX(id) - view.left;
+    int16_t y = terrY(id) - view.top;
+    int16_t power = territories[id].power;
+
+    // one digit is drawn at text size 3, two digits at text size 2
+    if (power >= 0 and power < 10) {
+        drawDigit(tft, x + 4, y + 2, power, 3, color);
+    }
+    else if (power >= 10 and power < 100) {
+        drawDigit(tft, x + 1, y + 5, power / 10, 2, color);
+        drawDigit(tft, x + 13, y + 5, power % 10, 2, color);
+    }
+    // anything else is drawn at text size 1, where four characters
+    // still fit inside the tile so nothing spills onto the map around
+    // it. Counts that need more are shown as the nearest that fits
+    else {
+        power = constrain(power, -999, 9999);
+        int16_t chars = (power < 0) + 1 + (abs(power) >= 10) + (abs(power) >= 100) + (abs(power) >= 1000);
+        drawNumber(tft, x + (terrWidth - (6*chars - 1)) / 2, y + (terrHeight - 7) / 2, power, 1, color);
     }
 }
 
-// draws one territory, given the upper left coordinates
+// fills a box given in map coordinates, only the part of it on screen
 /*
-Takes in:   player (owner of that territory)
-            id (to get the upper left corner of territory)
+Takes in:   view (the part of the map on screen)
+            x, y, w, h (the box on the map)
+            color (what to fill it with)
 
 Returns:    Nothing
 */
-void drawTerritory(int player, int id) {
-    // draws the territory a different color depending on who owns it, and what continent it is on
-    int continent = territories[id].cont;
-    int contWidth = 5;
-    uint16_t shift = (PAGENUMBER - 1) * DISP_WIDTH;
+void fillOnMap(const viewport &view, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (view.clipBox(x, y, w, h)) {
+        tft.fillRect(x, y, w, h, color);
+    }
+}
 
-    // fills in a colored rectangle where the territory will go - each color denotes which continent it is a part of
+// the color of a continent's border
+/*
+Takes in:   continent (which continent)
+
+Returns:    the color it is drawn in
+*/
+uint16_t continentColor(int continent) {
     switch (continent) {
         // 0: cyan, 1: magenta, 2: yellow, 3: green
-        case 0: tft.fillRect(territories[id].x - contWidth - shift, territories[id].y - contWidth, terrWidth + 2*contWidth, terrHeight + 2*contWidth, 0x07FF);
-            break;
-        case 1: tft.fillRect(territories[id].x - contWidth - shift, territories[id].y - contWidth, terrWidth + 2*contWidth, terrHeight + 2*contWidth, 0xF81F);
-            break;
-        case 2: tft.fillRect(territories[id].x - contWidth - shift, territories[id].y - contWidth, terrWidth + 2*contWidth, terrHeight + 2*contWidth, 0xFFE0);
-            break;
-        case 3: tft.fillRect(territories[id].x - contWidth - shift, territories[id].y - contWidth, terrWidth + 2*contWidth, terrHeight + 2*contWidth, 0x07E0);
-            break;
-    } 
+        case 0: return 0x07FF;
+        case 1: return 0xF81F;
+        case 2: return 0xFFE0;
+        default: return 0x07E0;
+    }
+}
+
+// draws one territory, given the upper left coordinates. Every pixel is
+// written once: the continent border is four bands around the inside
+// instead of a fill under it
+/*
+Takes in:   player (owner of that territory)
+            id (to get the upper left corner of territory)
+            border (false if the border is already on screen, e.g. only
+                    the owner or the armies changed)
+
+Returns:    Nothing
+*/
+void drawTerritory(int player, int id, bool border) {
+    viewport view = currentView();
+    int16_t x = terrX(id);
+    int16_t y = terrY(id);
+
+    // skip the territory if none of it is on screen
+    int16_t visibleX = x - contWidth;
+    int16_t visibleY = y - contWidth;
+    int16_t visibleW = terrWidth + 2*contWidth;
+    int16_t visibleH = terrHeight + 2*contWidth;
+    if (!view.clipBox(visibleX, visibleY, visibleW, visibleH)) {
+        return;
+    }
 
-    // fills in the player's color if they own that territory
-    // player 1 territories
+    // the continent color shows through if nobody owns it
+    uint16_t inside = continentColor(terrCont(id));
     if (player == 1) {
-        // prints all territories
-        tft.fillRect(territories[id].x - shift, territories[id].y, terrWidth, terrHeight, P1Color);   
+        inside = P1Color;
     }
-    
-    // player 2 territories
     else if (player == 2) {
-        // prints all territories
-        tft.fillRect(territories[id].x - shift, territories[id].y, terrWidth, terrHeight, P2Color);   
+        inside = P2Color;
     }
 
+    if (border) {
+        // each color denotes which continent it is a part of, the top and
+        // bottom bands cover the corners
+        uint16_t color = continentColor(terrCont(id));
+        fillOnMap(view, x - contWidth, y - contWidth, terrWidth + 2*contWidth, contWidth, color);
+        fillOnMap(view, x - contWidth, y + terrHeight, terrWidth + 2*contWidth, contWidth, color);
+        fillOnMap(view, x - contWidth, y, contWidth, terrHeight, color);
+        fillOnMap(view, x + terrWidth, y, contWidth, terrHeight, color);
+    }
+    fillOnMap(view, x, y, terrWidth, terrHeight, inside);
+
     // draws the powers inside the territory
     drawPowers(player, id);
-    
 }
 
-// draws the road from one connected territory to another
-/*
-Takes in:   id1, id2 (the ids of the 2 territories being connected)
-
-Returns:    Nothing
-*/
-void drawRoad(int id1, int id2) {
-    uint16_t shift = (PAGENUMBER - 1) * DISP_WIDTH;
-    tft.drawLine(territories[id1].x - shift + terrWidth/2, territories[id1].y + terrHeight/2,
-                 territories[id2].x - shift + terrWidth/2, territories[id2].y + terrHeight/2, 0xFFFF);
-}
-
-// draws all roads on the screen
+// draws all roads on the screen by streaming out the view's road list
 /*
 Takes in:   map (use methods to change the map)
 
 Returns:    Nothing
 */
 void drawAllRoads(masterMapGraph*& map) {
-    uint8_t added[NUM_TERR] = {0};
-    for (int i = 0; i < NUM_TERR; i++) {
-        for (HashTableIterator<IntWrapper> j = map->neighbours(i); !map->isLastNeighbour(i,j); j = map->nextNeighbour(i,j)) {
-            if (added[j.item().val] == 0) {
-                drawRoad(i, j.item().val);
-            }
-        }
-        added[i] = 1;
+    viewport view = currentView();
+    // use the other list if it was built for this view, otherwise
+    // replace the older one
+    if (!viewRoads[newestRoads].builtFor(view)) {
+        newestRoads ^= 1;
+    }
+    roadCache &roads = viewRoads[newestRoads];
+    // only rebuilds the list if the view or the roads changed since it was built
+    roads.update(map, view, terrWidth/2, terrHeight/2);
+    for (uint16_t i = 0; i < roads.size(); i++) {
+        tft.drawLine(roads[i].startX(), roads[i].y0, roads[i].endX(), roads[i].y1, 0xFFFF);
     }
 }
 
@@ -229,28 +313,28 @@ void updateMap(masterMapGraph*& map) {
 
     // draws all territories on the screen
     for (int i = 0; i < NUM_TERR; i++) {
-        drawTerritory(territories[i].team, i);
+        drawTerritory(territories[i].team, i, true);
     }
 }
 
 // draws the exit button (in white)
 void drawCancel() {
-    tft.setTextSize(2);
-    tft.drawRect(DISP_WIDTH, 0, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
-    tft.setCursor(DISP_WIDTH + 2, 4);
-    tft.println("CAN");
-    tft.setCursor(DISP_WIDTH + 2, 20);
-    tft.println("CEL");
+    panel.setTextSize(2);
+    panel.drawRect(DISP_WIDTH, 0, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
+    panel.setCursor(DISP_WIDTH + 2, 4);
+    panel.println("CAN");
+    panel.setCursor(DISP_WIDTH + 2, 20);
+    panel.println("CEL");
 }
 
 // draws the end turn button
 void drawEndTurn() {
-    tft.setTextSize(2);
-    tft.drawRect(DISP_WIDTH, 2*TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
-    tft.setCursor(DISP_WIDTH + 2, 4 + 2*TFT_PANEL_WIDTH);
-    tft.println("END");
-    tft.setCursor(DISP_WIDTH + 2, 20 + 2*TFT_PANEL_WIDTH);
-    tft.println("TRN");   
+    panel.setTextSize(2);
+    panel.drawRect(DISP_WIDTH, 2*TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
+    panel.setCursor(DISP_WIDTH + 2, 4 + 2*TFT_PANEL_WIDTH);
+    panel.println("END");
+    panel.setCursor(DISP_WIDTH + 2, 20 + 2*TFT_PANEL_WIDTH);
+    panel.println("TRN");   
 }
 
 // fills in to let user know who's turn it is
@@ -263,134 +347,242 @@ void drawPlayerTurn(int player) {
         color = P2Color;
     }
 
-    tft.fillRect(DISP_WIDTH + 1, TFT_PANEL_WIDTH + 1, TFT_PANEL_WIDTH - 2, TFT_PANEL_WIDTH - 2, color);
-    tft.fillRect(DISP_WIDTH + 1, 3*TFT_PANEL_WIDTH + 1, TFT_PANEL_WIDTH - 2, 2*TFT_PANEL_WIDTH - 2, color);
+    panel.fillRect(DISP_WIDTH + 1, TFT_PANEL_WIDTH + 1, TFT_PANEL_WIDTH - 2, TFT_PANEL_WIDTH - 2, color);
+    panel.fillRect(DISP_WIDTH + 1, 3*TFT_PANEL_WIDTH + 1, TFT_PANEL_WIDTH - 2, 2*TFT_PANEL_WIDTH - 2, color);
 }
 
 // draws the increase button for redistributing armies (in green)
 void drawIncrease() {
-    tft.drawRect(DISP_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0x07E0);
-    tft.fillRect(DISP_WIDTH + TFT_PANEL_WIDTH/2 - 1, TFT_PANEL_WIDTH, 2, TFT_PANEL_WIDTH - 4, 0x07E0);
-    tft.fillRect(DISP_WIDTH + 2, 3*TFT_PANEL_WIDTH/2 -1, TFT_PANEL_WIDTH - 4, 2, 0x07E0);
+    panel.drawRect(DISP_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0x07E0);
+    panel.fillRect(DISP_WIDTH + TFT_PANEL_WIDTH/2 - 1, TFT_PANEL_WIDTH, 2, TFT_PANEL_WIDTH - 4, 0x07E0);
+    panel.fillRect(DISP_WIDTH + 2, 3*TFT_PANEL_WIDTH/2 -1, TFT_PANEL_WIDTH - 4, 2, 0x07E0);
 }
 
 // draws the decrease button for redistributing armies (in red)
 void drawDecrease() {
-    tft.drawRect(DISP_WIDTH, 2*TFT_PANEL_WIDTH + 2, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0x07E0);
-    tft.fillRect(DISP_WIDTH + 2, 5*TFT_PANEL_WIDTH/2 -1, TFT_PANEL_WIDTH - 4, 2, 0x07E0);
+    panel.drawRect(DISP_WIDTH, 2*TFT_PANEL_WIDTH + 2, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0x07E0);
+    panel.fillRect(DISP_WIDTH + 2, 5*TFT_PANEL_WIDTH/2 -1, TFT_PANEL_WIDTH - 4, 2, 0x07E0);
 }
 
 // draws a right arrow to allow player to shift the screen to the right
 void drawScrollRight() {
-    tft.drawRect(DISP_WIDTH, 5*TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
-    tft.drawLine(DISP_WIDTH + 3, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + TFT_PANEL_WIDTH - 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
-    tft.drawLine(DISP_WIDTH + 2, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + TFT_PANEL_WIDTH - 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
-    tft.drawLine(DISP_WIDTH + 3, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + TFT_PANEL_WIDTH - 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
-    tft.drawLine(DISP_WIDTH + 2, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + TFT_PANEL_WIDTH - 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawRect(DISP_WIDTH, 5*TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
+    panel.drawLine(DISP_WIDTH + 3, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + TFT_PANEL_WIDTH - 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawLine(DISP_WIDTH + 2, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + TFT_PANEL_WIDTH - 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawLine(DISP_WIDTH + 3, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + TFT_PANEL_WIDTH - 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawLine(DISP_WIDTH + 2, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + TFT_PANEL_WIDTH - 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
 }
 
 // draws a left arrow to allow player to shift the screen to the left
 void drawScrollLeft() {
-    tft.drawRect(DISP_WIDTH, 5*TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
-    tft.drawLine(TFT_WIDTH - 3, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
-    tft.drawLine(TFT_WIDTH - 2, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
-    tft.drawLine(TFT_WIDTH - 3, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
-    tft.drawLine(TFT_WIDTH - 2, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);   
+    panel.drawRect(DISP_WIDTH, 5*TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, TFT_PANEL_WIDTH, 0xFFFF);
+    panel.drawLine(TFT_WIDTH - 3, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawLine(TFT_WIDTH - 2, 5*TFT_PANEL_WIDTH + 2, DISP_WIDTH + 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawLine(TFT_WIDTH - 3, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + 2, 11*TFT_PANEL_WIDTH/2, 0xFFFF);
+    panel.drawLine(TFT_WIDTH - 2, 6*TFT_PANEL_WIDTH - 2, DISP_WIDTH + 3, 11*TFT_PANEL_WIDTH/2, 0xFFFF);   
 }
 
-// prints the side bar
+// checks if the next screen is to the right, otherwise it goes back to the left
 /*
-Takes in:   player (whos turn it is)
+Returns:    true if the camera isn't at the right edge of the map yet
+*/
+bool scrollsRight() {
+    return cameraX < maxCameraX();
+}
 
-Returns:  Nothing
+// draws the scroll button pointing where the next screen is
+/*
+Returns:    Nothing
 */
-void sideBar(int player) {
-    // draws boundary
-    tft.fillRect(DISP_WIDTH, 0, TFT_PANEL_WIDTH, DISP_HEIGHT, 0x0000);
-    tft.drawRect(DISP_WIDTH, 0, TFT_PANEL_WIDTH, DISP_HEIGHT, 0xFFFF);
-    // draws scroll button depending on what page we are on
-    if (PAGENUMBER == 1) {
+void drawScrollButton() {
+    panel.fillRect(DISP_WIDTH + 1, 5*TFT_PANEL_WIDTH + 1, TFT_PANEL_WIDTH - 2, TFT_PANEL_WIDTH - 2, 0x0000);
+    if (scrollsRight()) {
         drawScrollRight();
     }
-    else if (PAGENUMBER == 2) {
+    else {
         drawScrollLeft();
     }
+    sideBarScrollsRight = scrollsRight();
+}
+
+// prints how many armies are left to place
+/*
+Returns:    Nothing
+*/
+void drawArmiesLeft() {
+    panel.setTextSize(1);
+    panel.setTextColor(0xFFFF);
+    panel.setCursor(DISP_WIDTH + 8, 3*TFT_PANEL_WIDTH + 4);
+    panel.println("DIST");
+    panel.setTextSize(2);
+    panel.setCursor(DISP_WIDTH + 14, 3*TFT_PANEL_WIDTH + 20);
+    panel.print(armiesLeft);
+}
+
+// prints the side bar, only what changed since the last time is sent
+// to the screen
+/*
+Takes in:   player (whos turn it is)
+
+Returns:  Nothing
+*/
+void sideBar(int player) {
+#if DISPLAY_LIST
+    panel.begin();
+#endif
+    // draws boundary
+    panel.fillRect(DISP_WIDTH, 0, TFT_PANEL_WIDTH, DISP_HEIGHT, 0x0000);
+    panel.drawRect(DISP_WIDTH, 0, TFT_PANEL_WIDTH, DISP_HEIGHT, 0xFFFF);
+    // draws scroll button depending on where the camera is
+    drawScrollButton();
     // draws end turn and cancel buttons
     drawCancel();
     drawEndTurn();
     drawPlayerTurn(player);
+    if (armiesLeft >= 0) {
+        drawArmiesLeft();
+    }
+    sideBarPlayer = player;
+#if DISPLAY_LIST
+    panel.flush();
+#endif
 }
 
-// Uses insertion sort to sort the territories by x-coordinate so we can
-// quickly see what territory was touched by the user
+// shows a new number of armies left to place. The display list finds
+// what changed on its own, without it only the number's box is painted
+// again, the rest of the side bar is still on screen
 /*
-Takes in:   xSortedTerritories (territories sorted by x-coordinate for binary search)
-            NUM_TERR (total number of territories)
+Takes in:   player (whos turn it is)
+            armies (the armies left to place)
+
+Returns:    Nothing
+*/
+void updateArmiesLeft(int player, int armies) {
+#if DISPLAY_LIST
+    armiesLeft = armies;
+    sideBar(player);
+#else
+    // the whole side bar if it is for the other player or doesn't show
+    // the armies yet
+    bool whole = sideBarPlayer != player or armiesLeft < 0;
+    armiesLeft = armies;
+    if (whole) {
+        sideBar(player);
+        return;
+    }
+    uint16_t color = (player == 1) ? P1Color : P2Color;
+    tft.fillRect(DISP_WIDTH + 1, 3*TFT_PANEL_WIDTH + 20, TFT_PANEL_WIDTH - 2, TFT_PANEL_WIDTH, color);
+    tft.setTextColor(0xFFFF);
+    tft.setTextSize(2);
+    tft.setCursor(DISP_WIDTH + 14, 3*TFT_PANEL_WIDTH + 20);
+    tft.print(armiesLeft);
+#endif
+}
+
+// marks a territory so the next flushDirty redraws it, and the next
+// sync sends it to the other board
+/*
+Takes in:   id (the territory that changed)
 
 Returns:  Nothing
 */
-void sortTerritories(territory *&xSortedTerritories, uint8_t NUM_TERR) {
-    territory key;
-    int j;
+void markDirty(int id) {
+    dirty[id / 8] |= 1 << (id % 8);
+    unsynced.mark(id);
+}
 
-    for (int i = 1; i < NUM_TERR; i++) {
-        key = xSortedTerritories[i];
-        j = i - 1;
+// redraws only the territories marked since the last flush, and the side
+// bar only if it was drawn for a different player
+/*
+Takes in:   player (whos turn it is)
 
-        while (j >= 0 && xSortedTerritories[j].x > key.x) {
-            xSortedTerritories[j + 1] = xSortedTerritories[j];
-            j -= 1;
+Returns:  Nothing
+*/
+void flushDirty(int player) {
+    startFrame(tft);
+    for (int i = 0; i < (NUM_TERR + 7) / 8; i++) {
+        if (dirty[i] == 0) {
+            continue;
         }
+        for (int ID = 8*i; ID < 8*i + 8 and ID < NUM_TERR; ID++) {
+            if (dirty[i] & (1 << (ID % 8))) {
+                // a territory never changes continent, so its border is
+                // still on screen
+                drawTerritory(territories[ID].team, ID, false);
+            }
+        }
+        dirty[i] = 0;
+    }
 
-        xSortedTerritories[j + 1] = key;
+    if (sideBarPlayer != player) {
+        sideBar(player);
     }
+    reportFrame(tft, "Redraw");
 }
 
-// randomly draws single pixel stars to the screen for visual effect
-void drawStars() {
-    int x, y;
-    for (int i = 0; i < 250; i++) {
-        // random x and y coordinate
-        x = random(0, DISP_WIDTH);
-        y = random(0, DISP_HEIGHT);
+// draws the stars in a part of the map area that was just cleared, the
+// same stars are always in the same place on the map
+/*
+Takes in:   x, y, w, h (the cleared box, in screen coordinates)
 
-        tft.drawPixel(x, y, 0xFFFF);
-    }
+Returns:    Nothing
+*/
+void drawStars(int16_t x, int16_t y, int16_t w, int16_t h) {
+    drawStarfield(tft, currentView(), x, y, w, h, 0xFFFF);
 }
 
-// redraws the stars, roads, territories and buttons
+// redraws the roads, territories and buttons (the stars are only drawn
+// where the screen was cleared)
 /*
 Takes in:   player (whos turn it is)
-            xSortedTerritories (territories sorted by x-coordinate for binary search)
             map (use methods to change the map)
             NUM_TERR (total number of territories)
 
 Returns:  Nothing
 */
-void drawAll (masterMapGraph *&map, territory *&xSortedTerritories, int player) {
-    drawStars();
+void drawAll (masterMapGraph *&map, int player) {
+    startFrame(tft);
 
     // draws all roads to the screen
     drawAllRoads(map);
 
     // draws all territories on the screen
     for (int ID = 0; ID < NUM_TERR; ID++) {
-        drawTerritory(territories[ID].team, ID);
+        drawTerritory(territories[ID].team, ID, true);
     }
 
     // draws the sidebar and buttons
     sideBar(player);
+    reportFrame(tft, "Full map");
+}
+
+// checks that the joystick reads centred a few times in a row, a
+// missing or loose joystick leaves its pins floating
+/*
+Returns:    true if every reading was inside the dead zone
+*/
+bool joystickCentred() {
+    for (int i = 0; i < JOY_CHECKS; i++) {
+        // abs is a macro, so each axis is read into a local first
+        int dx = analogRead(JOY_HORIZ_ANALOG) - JOY_CENTRE;
+        int dy = analogRead(JOY_VERT_ANALOG) - JOY_CENTRE;
+        if (abs(dx) >= JOY_DEADZONE or abs(dy) >= JOY_DEADZONE) {
+            return false;
+        }
+        delay(10);
+    }
+    return true;
 }
 
 // setup function for beginning the game
 /*
 Takes in:   player (whos turn it is)
-            xSortedTerritories (territories sorted by x-coordinate for binary search)
+            grid (finds which territory was touched)
             map (use methods to change the map)
 
 Returns:  Nothing
 */
-void setup(masterMapGraph *&map, territory *&xSortedTerritories, int player) {
+void setup(masterMapGraph *&map, touchGrid &grid, int player) {
     // initializes SD card and serial comms
     init();
     tft.begin();
@@ -398,7 +590,7 @@ void setup(masterMapGraph *&map, territory *&xSortedTerritories, int player) {
     
     // Welcome graphics
     tft.fillScreen(ILI9341_BLACK);
-    drawStars();
+    drawStars(0, 0, DISP_WIDTH, DISP_HEIGHT);
     tft.setTextSize(3);
     tft.setTextColor(0xFFFF);
     tft.println("WELCOME TO: ");
@@ -409,8 +601,15 @@ void setup(masterMapGraph *&map, territory *&xSortedTerritories, int player) {
 
     // initializes serial communications
     Serial.begin(9600);
-    Serial3.begin(9600);
+    // the link starts at the slowest rate, player 1 speeds it up below
+    Serial3.begin(outgoing.baud());
     Serial.println("Start");
+#if JOYSTICK
+    joystickFound = joystickCentred();
+    if (!joystickFound) {
+        Serial.println("Joystick isn't centred, panning with it is off");
+    }
+#endif
     if (!SD.begin(SD_CS)) {
         Serial.println("FAILED");
         Serial.println("Make sure the SD card is inserted properly!");
@@ -418,20 +617,44 @@ void setup(masterMapGraph *&map, territory *&xSortedTerritories, int player) {
     }
 
     // takes the custom game map (territories) and turns it into a map so we can easily change it
+    reportHeap("Heap before map");
     map = makeMap(territories);
     NUM_TERR = map->size();
+    reportHeap("Heap after map");
+    reportPool("Edge pool", map->nodePool());
 
-    // creates a temporary map which we sort for the binary search later
-    xSortedTerritories = new territory[NUM_TERR];
+    // the camera can pan until the far continent borders are on screen
     for (int i = 0; i < NUM_TERR; ++i)
     {
-        xSortedTerritories[i] = territories[i];
+        if (terrX(i) + terrWidth + contWidth > mapWidth) {
+            mapWidth = terrX(i) + terrWidth + contWidth;
+        }
+        if (terrY(i) + terrHeight + contWidth > mapHeight) {
+            mapHeight = terrY(i) + terrHeight + contWidth;
+        }
     }
 
-    sortTerritories(xSortedTerritories, NUM_TERR);
+    // buckets the territories so a touch only checks the ones near it
+    grid.build(NUM_TERR, mapWidth, mapHeight, terrWidth, terrHeight);
 
-    // draws the full map to the screen
-    drawAll(map, xSortedTerritories, player);
+    dirty = new uint8_t[(NUM_TERR + 7) / 8];
+    for (int i = 0; i < (NUM_TERR + 7) / 8; ++i)
+    {
+        dirty[i] = 0;
+    }
+    unsynced.begin(NUM_TERR);
+
+    // draws the full map to the screen, it was cleared after the welcome
+    // screen so the whole sky needs its stars
+    drawStars(0, 0, DISP_WIDTH, DISP_HEIGHT);
+    drawAll(map, player);
+
+    // finds the fastest rate both ways of the link work at, player 2
+    // answers while it waits for the first turn
+    if (player == 1) {
+        negotiateRate(incoming, outgoing);
+        reportLink(incoming, outgoing);
+    }
 }
 
 /*
@@ -482,7 +705,12 @@ void attack(int player, int attackingID, int defendingID, masterMapGraph *&gameM
             territories[defendingID].power = (territories[attackingID].power - 1);
             territories[attackingID].power = 1;
             territories[defendingID].team = player;
-            gameMap->flip(territories[defendingID], territories);
+            int captured = gameMap->flip(territories[defendingID]);
+            // let the serial monitor know as soon as a whole continent is taken
+            if (captured >= 0) {
+                Serial.print("Continent captured: ");
+                Serial.println(captured);
+            }
             break;
         }
         // check to see if the attacking player has 1 army left
@@ -513,150 +741,383 @@ void attack(int player, int attackingID, int defendingID, masterMapGraph *&gameM
         while (true) {}
     }
 
-    // draws all territories on the screen
-    for (int ID = 0; ID < NUM_TERR; ID++) {
-        drawTerritory(territories[ID].team, ID);
-    }
-    sideBar(player);
-
+    // only the two territories in the battle changed (the attacker is
+    // redrawn even if it couldn't attack, to clear its outline)
+    markDirty(attackingID);
+    markDirty(defendingID);
+    flushDirty(player);
 }
 
-// uses a binary search algorithm to quickly return the ID of the territory that was touched (returns -1 if not)
+// finds the territory that was touched using the grid built in setup (returns -1 if not)
 /*
-Takes in:   xSortedTerritories (territories sorted by x-coordinate for binary search)
-            start (0 in most cases)
-            end (total number of territories being searched)
+Takes in:   grid (the territories bucketed by where they are)
             x_coord (the x coordinate of the users touch)
-            y_coord (the y coordinate of the users touch)            
+            y_coord (the y coordinate of the users touch)
 
 Returns:    the id of the touched territory (-1 if its not a valid territory)
 */
-int terrTouched(territory *xSortedTerritories, int start, int end, int x_coord, int y_coord) {
-    int ID;
-    uint16_t shift = (PAGENUMBER - 1) * DISP_WIDTH;
-    x_coord += shift;
-    end --;
+int terrTouched(touchGrid &grid, int x_coord, int y_coord) {
+    // touches are on the screen, territories are on the map
+    return grid.find(x_coord + cameraX, y_coord + cameraY);
+}
 
-    while (start <= end) {
-        ID = start + (end - start)/2;
+// draws the outline around a territory, or the part of it that is on screen
+/*
+Takes in:   id (the territory to outline)
+            color (white to select it, the owner's color to clear it)
 
-        // if the x coordinate is within range of the users touch
-        if (x_coord > xSortedTerritories[ID].x and x_coord < (xSortedTerritories[ID].x + terrWidth)) {
+Returns:    Nothing
+*/
+void drawOutline(int id, uint16_t color) {
+    viewport view = currentView();
+    // top, bottom, left and right sides, each 2 pixels thick
+    int16_t sides[4][4] = {
+        {(int16_t) terrX(id), (int16_t) terrY(id), terrWidth, 2},
+        {(int16_t) terrX(id), (int16_t) (terrY(id) + terrHeight - 2), terrWidth, 2},
+        {(int16_t) terrX(id), (int16_t) (terrY(id) + 2), 2, terrHeight - 4},
+        {(int16_t) (terrX(id) + terrWidth - 2), (int16_t) (terrY(id) + 2), 2, terrHeight - 4}
+    };
+    for (int i = 0; i < 4; i++) {
+        fillOnMap(view, sides[i][0], sides[i][1], sides[i][2], sides[i][3], color);
+    }
+}
 
-            // if the y coordinate is within range of the users touch
-            if (y_coord > xSortedTerritories[ID].y and y_coord < (xSortedTerritories[ID].y + terrHeight)) {
-                // returns the ID of the touched territory
-                return xSortedTerritories[ID].id;
-            }
-            // if the x-coordinates are fine, but the y-coordinates aren't
-            else {
-                return -1;
-            }
+// draws the map at the camera onto a map area that has been blanked,
+// the side bar is left alone
+/*
+Takes in:   gameMap (use methods to change the map)
+
+Returns:    Nothing
+*/
+void drawMapContents(masterMapGraph *&gameMap) {
+    drawStars(0, 0, DISP_WIDTH, DISP_HEIGHT);
+
+    // draws the roads and the territories that are on screen
+    updateMap(gameMap);
+
+    // keeps the selected territory outlined
+    if (selectedID != -1) {
+        drawOutline(selectedID, 0xFFFF);
+    }
+}
+
+// redraws the map area at the camera, the side bar is left alone
+/*
+Takes in:   gameMap (use methods to change the map)
+
+Returns:    Nothing
+*/
+void drawMapArea(masterMapGraph *&gameMap) {
+    tft.fillRect(0, 0, DISP_WIDTH, DISP_HEIGHT, ILI9341_BLACK);
+    drawMapContents(gameMap);
+}
+
+// blanks what is left of a box drawn before the camera moved by dx, dy
+// once the same box is drawn at the camera now, i.e. the strip it moved
+// off of
+/*
+Takes in:   view (the part of the map on screen now)
+            x, y, w, h (the box on the map)
+            dx, dy (how far the camera moved, in pixels)
+
+Returns:    Nothing
+*/
+void eraseUncovered(const viewport &view, int16_t x, int16_t y, int16_t w, int16_t h, int dx, int dy) {
+    // the old pixels are where the box moved by dx, dy is on the map now
+    int16_t oldX = x + dx;
+    int16_t oldY = y + dy;
+    if (abs(dx) >= w or abs(dy) >= h) {
+        fillOnMap(view, oldX, oldY, w, h, ILI9341_BLACK);
+        return;
+    }
+    if (dx > 0) {
+        fillOnMap(view, x + w, oldY, dx, h, ILI9341_BLACK);
+    }
+    else if (dx < 0) {
+        fillOnMap(view, oldX, oldY, -dx, h, ILI9341_BLACK);
+    }
+    if (dy > 0) {
+        fillOnMap(view, oldX, y + h, w, dy, ILI9341_BLACK);
+    }
+    else if (dy < 0) {
+        fillOnMap(view, oldX, oldY, w, -dy, ILI9341_BLACK);
+    }
+}
+
+// swaps two coordinates
+/*
+Takes in:   a, b (the coordinates)
+
+Returns:    Nothing
+*/
+void swapCoords(int16_t &a, int16_t &b) {
+    int16_t t = a;
+    a = b;
+    b = t;
+}
+
+// checks if a point on the screen is in the box of the territory whose
+// centre is at (centreX, centreY), continent border included
+/*
+Takes in:   x, y (the point)
+            centreX, centreY (the territory's centre)
+
+Returns:    true if the point is in its box
+*/
+bool nearCentre(int16_t x, int16_t y, int16_t centreX, int16_t centreY) {
+    return abs(x - centreX) <= (terrWidth - 1)/2 + contWidth and abs(y - centreY) <= (terrHeight - 1)/2 + contWidth;
+}
+
+// draws a road from a road list over in black, the same pixels
+// tft.drawLine() drew it with (the library's Bresenham), but leaves out
+// the parts in the territories at its ends. Those get blanked or drawn
+// over with the territory anyway, and drawing a slanted line costs an
+// address window per pixel
+/*
+Takes in:   road (the road, in screen coordinates)
+
+Returns:    Nothing
+*/
+void eraseRoad(const roadSegment &road) {
+    int16_t x0 = road.startX();
+    int16_t y0 = road.y0;
+    int16_t x1 = road.endX();
+    int16_t y1 = road.y1;
+    // an end cut off at the edge of the map area isn't a territory's
+    // centre, the whole road is drawn over up to there
+    bool centre0 = x0 > 0 and x0 < DISP_WIDTH - 1 and y0 > 0 and y0 < DISP_HEIGHT - 1;
+    bool centre1 = x1 > 0 and x1 < DISP_WIDTH - 1 and y1 > 0 and y1 < DISP_HEIGHT - 1;
+
+    int16_t ax = x0, ay = y0, bx = x1, by = y1;
+    bool steep = abs(by - ay) > abs(bx - ax);
+    if (steep) {
+        swapCoords(ax, ay);
+        swapCoords(bx, by);
+    }
+    // whether the ends at a and b are centres
+    bool centreA = centre0;
+    bool centreB = centre1;
+    if (ax > bx) {
+        swapCoords(ax, bx);
+        swapCoords(ay, by);
+        centreA = centre1;
+        centreB = centre0;
+    }
+    int16_t dx = bx - ax;
+    int16_t dy = abs(by - ay);
+
+    // a straight road went out as one rectangle, so it is blanked as one
+    if (dy == 0) {
+        int16_t reach = 1 + (steep ? (terrHeight - 1)/2 : (terrWidth - 1)/2) + contWidth;
+        int16_t from = ax + (centreA ? reach : 0);
+        int16_t to = bx - (centreB ? reach : 0);
+        if (from <= to and steep) {
+            tft.fillRect(ay, from, 1, to - from + 1, ILI9341_BLACK);
+        }
+        else if (from <= to) {
+            tft.fillRect(from, ay, to - from + 1, 1, ILI9341_BLACK);
+        }
+        return;
+    }
+
+    int16_t err = dx / 2;
+    int16_t ystep = (ay < by) ? 1 : -1;
+
+    tft.startWrite();
+    for (; ax <= bx; ax++) {
+        int16_t x = steep ? ay : ax;
+        int16_t y = steep ? ax : ay;
+        if (!(centre0 and nearCentre(x, y, x0, y0)) and !(centre1 and nearCentre(x, y, x1, y1))) {
+            tft.writePixel(x, y, ILI9341_BLACK);
+        }
+        err -= dy;
+        if (err < 0) {
+            ay += ystep;
+            err += dx;
         }
-        // if the territory with ID is further right than users touch
-        else if (x_coord < xSortedTerritories[ID].x) {
-            end = ID - 1;
-            
+    }
+    tft.endWrite();
+}
+
+// blanks the map area for the camera to move by dx, dy, but only where
+// something is drawn: the stars and roads go over again in black, and
+// each territory only blanks the strip it moves off of, as it is drawn
+// again anyway. Clearing the whole map area sends more than all of that
+/*
+Takes in:   dx, dy (how far the camera is about to move, in pixels)
+
+Returns:    false if it blanked nothing, the whole map area has to be
+            cleared (a jump of a whole screen, or the roads on screen
+            aren't in the road lists)
+*/
+bool eraseForPan(int dx, int dy) {
+    viewport view = currentView();
+    roadCache &roads = viewRoads[newestRoads];
+    if (abs(dx) >= DISP_WIDTH or abs(dy) >= DISP_HEIGHT or !roads.builtFor(view)) {
+        return false;
+    }
+    drawStarfield(tft, view, 0, 0, DISP_WIDTH, DISP_HEIGHT, ILI9341_BLACK);
+    for (uint16_t i = 0; i < roads.size(); i++) {
+        eraseRoad(roads[i]);
+    }
+
+    view.left += dx;
+    view.top += dy;
+    for (int i = 0; i < NUM_TERR; i++) {
+        eraseUncovered(view, terrX(i) - contWidth, terrY(i) - contWidth, terrWidth + 2*contWidth, terrHeight + 2*contWidth, dx, dy);
+    }
+    return true;
+}
+
+// moves the camera one screen on, left to right and then top to bottom,
+// going back to the start after the last screen
+/*
+Returns:    Nothing
+*/
+void nextScreen() {
+    if (cameraX < maxCameraX()) {
+        cameraX = constrain(cameraX + DISP_WIDTH, 0, maxCameraX());
+    }
+    else {
+        cameraX = 0;
+        if (cameraY < maxCameraY()) {
+            cameraY = constrain(cameraY + DISP_HEIGHT, 0, maxCameraY());
         }
-        // if the territory with ID is further left than users touch
         else {
-            start = ID + 1;
+            cameraY = 0;
         }
     }
-    // return -1 if the user didn't touch a territory
-    return -1;
 }
 
-// changes the page displayed by the arduino
+// changes the screen displayed by the arduino
 /*
 Takes in:   player (whos turn it is)
             gameMap (to build map/ use methods to change the map)
 */
 void nextPageTouch(masterMapGraph *&gameMap, int player) {
+    startFrame(tft);
+
+    nextScreen();
+    drawMapArea(gameMap);
+
+    // draws the sidebar for the buttons
+    sideBar(player);
+    reportFrame(tft, "Page switch");
+}
+
+// moves the camera by dx, dy (stopping at the edges of the map) and
+// redraws the map area if it moved, blanking only what moved
+/*
+Takes in:   gameMap (use methods to change the map)
+            dx, dy (how far to move the camera, in pixels)
+
+Returns:    Nothing
+*/
+void panCamera(masterMapGraph *&gameMap, int dx, int dy) {
+    int16_t x = constrain(cameraX + dx, 0, maxCameraX());
+    int16_t y = constrain(cameraY + dy, 0, maxCameraY());
+    if (x == cameraX and y == cameraY) {
+        return;
+    }
 
-    // if the change screen button is pressed
-    if (PAGENUMBER == 2) {
-        PAGENUMBER = 1;
-        tft.fillScreen(ILI9341_BLACK);
-        drawStars();
+    startFrame(tft);
+    bool erased = eraseForPan(x - cameraX, y - cameraY);
+    cameraX = x;
+    cameraY = y;
+    if (erased) {
+        drawMapContents(gameMap);
     }
-    else if (PAGENUMBER == 1) {
-        PAGENUMBER = 2;
-        tft.fillScreen(ILI9341_BLACK);
-        drawStars();
+    else {
+        drawMapArea(gameMap);
     }
 
-    // draws all roads to the screen
-    drawAllRoads(gameMap);
+    // the scroll button flips once the camera reaches the right edge
+    if (sideBarScrollsRight != scrollsRight()) {
+        sideBar(sideBarPlayer);
+    }
+    reportFrame(tft, "Pan");
+}
 
-    // draws all territories on the screen
-    for (int ID = 0; ID < NUM_TERR; ID++) {
-        drawTerritory(territories[ID].team, ID);
+// pans the camera with the joystick, faster the further it is pushed
+/*
+Takes in:   gameMap (use methods to change the map)
+
+Returns:    Nothing
+*/
+void pollJoystick(masterMapGraph *&gameMap) {
+    if (!joystickFound) {
+        return;
     }
 
-    // draws the sidebar for the buttons
-    sideBar(player);
+    // the horizontal axis reads higher to the left
+    int dx = JOY_CENTRE - analogRead(JOY_HORIZ_ANALOG);
+    int dy = analogRead(JOY_VERT_ANALOG) - JOY_CENTRE;
+
+    if (abs(dx) < JOY_DEADZONE) {
+        dx = 0;
+    }
+    if (abs(dy) < JOY_DEADZONE) {
+        dy = 0;
+    }
+    if (dx != 0 or dy != 0) {
+        panCamera(gameMap, dx / JOY_STEPS_PER_PIXEL * JOY_PAN_SPEED, dy / JOY_STEPS_PER_PIXEL * JOY_PAN_SPEED);
+    }
+}
+
+// gets the coordinates of the users touch
+/*
+Takes in:   gameMap (to redraw the map when the joystick pans it)
+            touch_x (x coordinate of users touch)
+            touch_y (y coordinate of users touch)
+
+Returns:  Nothing
+*/
+void getTouch(masterMapGraph *&gameMap, int16_t &touch_x, int16_t &touch_y) {
+    TSPoint touch;
+    do {
+        // the joystick pans the map while we wait
+        pollJoystick(gameMap);
+        touch = ts.getPoint();                
+    } while(touch.z < MINPRESSURE or touch.z > MAXPRESSURE);
+
+    // maps touch to screen
+    touch_x = map(touch.y, TS_MINY, TS_MAXY, TFT_WIDTH - 1, 0) - 20;
+    touch_y = map(touch.x, TS_MINX, TS_MAXX, 0, TFT_HEIGHT - 1); 
+
+    // small delay so touches don't spam
+    delay(100);
 }
 
 /*
 For when the 2 players distribute their armies at the beginning of their turn
 
 Takes in:   player (whos turn it is)
-            xSortedTerritories (territories sorted by x-coordinate for binary search)
+            grid (finds which territory was touched)
             gameMap (use methods to change the map)
 */
-void distribute(int player, territory* xSortedTerritories, masterMapGraph *&gameMap) {
+void distribute(int player, touchGrid &grid, masterMapGraph *&gameMap) {
     int armies = 4;
     int16_t touch_x, touch_y;
     int ID;
     // calculates the total number of armies the player gets 
-    armies += gameMap->continentBonus(player, territories);
+    armies += gameMap->continentBonus(player);
 
-    // sets display settings
-    tft.setTextSize(1); 
-    tft.setTextColor(0xFFFF);
-    tft.setCursor(DISP_WIDTH + 8, 3*TFT_PANEL_WIDTH + 4);
-    tft.println("DIST");
-
-    // for displaying number
-    tft.setTextSize(2);
-    tft.setCursor(DISP_WIDTH + 14, 3*TFT_PANEL_WIDTH + 20);
-
-    // sets a color depending on whos turn it is
-    int color;
-    if (player == 1) {
-        color = P1Color;
-    }
-    else {
-        color = P2Color;
-    }
-
-    tft.print(armies);
+    // shows the number to distribute in the side bar
+    updateArmiesLeft(player, armies);
 
     // while there are still armies to distribute
     while (armies > 0) {
 
-        getTouch(touch_x, touch_y);
-        ID = terrTouched(xSortedTerritories, 0, NUM_TERR, touch_x, touch_y);
+        getTouch(gameMap, touch_x, touch_y);
+        ID = terrTouched(grid, touch_x, touch_y);
         while (ID == -1 or touch_x > DISP_WIDTH and touch_y > 5*TFT_PANEL_WIDTH) {
             if (touch_x > DISP_WIDTH and touch_y > 5*TFT_PANEL_WIDTH) {
                 // goes to the next page
                 nextPageTouch(gameMap, player);
-
-                // prints dist on the screen when the screen changes
-                tft.setTextSize(1); 
-                tft.setTextColor(0xFFFF);
-                tft.setCursor(DISP_WIDTH + 8, 3*TFT_PANEL_WIDTH + 4);
-                tft.println("DIST");
-
-                // number of armies remaining to be distributed
-                tft.setTextSize(2); 
-                tft.setCursor(DISP_WIDTH + 14, 3*TFT_PANEL_WIDTH + 20);
-                tft.print(armies);
             }
             // gets the touch if the while loop condition is satisfied
-            getTouch(touch_x, touch_y);
-            ID = terrTouched(xSortedTerritories, 0, NUM_TERR, touch_x, touch_y);
+            getTouch(gameMap, touch_x, touch_y);
+            ID = terrTouched(grid, touch_x, touch_y);
         }
 
         // if the player doesn't own that territory, get the input again
@@ -667,55 +1128,43 @@ void distribute(int player, territory* xSortedTerritories, masterMapGraph *&game
         // distribute to the territory with the ID, subtract 1 from the remaining armies
         territories[ID].power++;
         armies--;
-        drawTerritory(player, ID);
+        markDirty(ID);
+        flushDirty(player);
 
-        // format and print the number of armies
-        tft.fillRect(DISP_WIDTH + 1, 3*TFT_PANEL_WIDTH + 20, TFT_PANEL_WIDTH - 2, TFT_PANEL_WIDTH, color);
-        tft.setCursor(DISP_WIDTH + 14, 3*TFT_PANEL_WIDTH + 20);
-        tft.setTextSize(2);
-        tft.setTextColor(0xFFFF);
-        tft.print(armies);
+        // only the number changes in the side bar
+        updateArmiesLeft(player, armies);
 
         // short delay to not spam
         delay(200);
     }
 
     // redraws the sidebar once all armies are distributed
+    armiesLeft = -1;
     sideBar(player);
 }
 
 // the basic game turn - player 1 attacks, player 2 attacks, both players redistribute their armies
 /*
 Takes in:   player (whos turn it is)
-            xSortedTerritories (territories sorted by x-coordinate for binary search)
+            grid (finds which territory was touched)
             gameMap (to build map/ use methods to change the map)
 */
-void playerTurn (int player, territory* xSortedTerritories, masterMapGraph *&gameMap) {
+void playerTurn (int player, touchGrid &grid, masterMapGraph *&gameMap) {
     
     int attackingID;
     int defendingID;
 
     int16_t touch_x, touch_y;
-    uint16_t shift = (PAGENUMBER - 1) * DISP_WIDTH;
 
     while (true) {
 
         // waits for a touch
-        getTouch(touch_x, touch_y);
+        getTouch(gameMap, touch_x, touch_y);
 
         // if the touch is to the right of the map
         if (touch_x > DISP_WIDTH) {
             // cancel button
             if (touch_y < TFT_PANEL_WIDTH) {
-                shift = (PAGENUMBER - 1) * DISP_WIDTH;
-                if (player == 1) {
-                    tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, P1Color);
-                    tft.drawRect(territories[attackingID].x + 1 - shift, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, P1Color);
-                }
-                else {
-                    tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, P2Color);
-                    tft.drawRect(territories[attackingID].x + 1 - shift, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, P2Color);
-                }
                 continue; //--------------------------------------
             }
             // end turn
@@ -735,7 +1184,7 @@ void playerTurn (int player, territory* xSortedTerritories, masterMapGraph *&gam
 
         // if the touch is somewhere on the map
         else {
-            attackingID = terrTouched(xSortedTerritories, 0, NUM_TERR, touch_x, touch_y);
+            attackingID = terrTouched(grid, touch_x, touch_y);
                        
             // if the user doesn't touch a territory
             if (attackingID == -1) {
@@ -749,50 +1198,34 @@ void playerTurn (int player, territory* xSortedTerritories, masterMapGraph *&gam
             // if a valid territory is touched
             else {
                 delay(200);
-                shift = (PAGENUMBER - 1) * DISP_WIDTH;
-                tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, 0xFFFF);
-                tft.drawRect(territories[attackingID].x - shift + 1, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, 0xFFFF);
+                selectedID = attackingID;
+                drawOutline(attackingID, 0xFFFF);
 
                 while (true) {
                     // waits for second territory to be touched
-                    getTouch(touch_x, touch_y);
+                    getTouch(gameMap, touch_x, touch_y);
 
                     // if the touch is to the right of the map
                     if (touch_x > DISP_WIDTH) {
                         // end turn button
                         if (touch_y < TFT_PANEL_WIDTH) {
-                            // calculate shift
-                            shift = (PAGENUMBER - 1) * DISP_WIDTH;
                             if (player == 1) {
-                                tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, P1Color);
-                                tft.drawRect(territories[attackingID].x + 1 - shift, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, P1Color);
+                                drawOutline(attackingID, P1Color);
                             }
                             else {
-                                tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, P2Color);
-                                tft.drawRect(territories[attackingID].x + 1 - shift, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, P2Color);
+                                drawOutline(attackingID, P2Color);
                             }
                             break; //--------------------------------------
                         }
                         // end turn button
                         else if (touch_y > 2*TFT_PANEL_WIDTH and touch_y < 3*TFT_PANEL_WIDTH) {
+                            selectedID = -1;
                             delay(250);
                             return;
                         }
-                        // other page button
+                        // other page button (the outline is redrawn with the map)
                         else if (touch_y > (DISP_HEIGHT - TFT_PANEL_WIDTH) and touch_x > DISP_WIDTH) {
                             nextPageTouch(gameMap, player);
-                            if (PAGENUMBER == 1 and territories[attackingID].x <= 280) {
-                                shift = (PAGENUMBER - 1) * DISP_WIDTH;
-                                tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, 0xFFFF);
-                                tft.drawRect(territories[attackingID].x + 1 - shift, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, 0xFFFF);
-                            }
-                            else if (PAGENUMBER == 2 and territories[attackingID].x >= 280) {
-                                shift = (PAGENUMBER - 1) * DISP_WIDTH;
-                                tft.drawRect(territories[attackingID].x - shift, territories[attackingID].y, terrWidth, terrHeight, 0xFFFF);
-                                tft.drawRect(territories[attackingID].x + 1 - shift, territories[attackingID].y + 1, terrWidth - 2, terrHeight - 2, 0xFFFF);
-                                Serial.println(territories[attackingID].x - shift);
-                            }
-                            
                         }
                         // no button pressed
                         else {
@@ -802,7 +1235,7 @@ void playerTurn (int player, territory* xSortedTerritories, masterMapGraph *&gam
 
                     // if somewhere on the map is touched
                     else {
-                        defendingID = terrTouched(xSortedTerritories, 0, NUM_TERR, touch_x, touch_y);
+                        defendingID = terrTouched(grid, touch_x, touch_y);
 
                         // if the user doesn't touch a territory
                         if (defendingID == -1) {
@@ -826,14 +1259,16 @@ void playerTurn (int player, territory* xSortedTerritories, masterMapGraph *&gam
                                 if (territories[attackingID].power > 1) {
                                     territories[attackingID].power--;
                                     territories[defendingID].power++;
-                                    drawTerritory(player, attackingID);
-                                    drawTerritory(player, defendingID);
+                                    markDirty(attackingID);
+                                    markDirty(defendingID);
+                                    flushDirty(player);
                                 }
                                 break;
                             }
                         }
                     } 
                 }
+                selectedID = -1;
                 // delay so no double presses
                 delay(200);
             }    
@@ -846,49 +1281,46 @@ void playerTurn (int player, territory* xSortedTerritories, masterMapGraph *&gam
 takes in: player (whos turn it is)
 */
 void gameLoop(int player) {
-    territory* xSortedTerritories;
+    touchGrid grid;
     masterMapGraph* gameMap;
 
-    setup(gameMap, xSortedTerritories, player);
+    setup(gameMap, grid, player);
 
-    // playerTurn(player, xSortedTerritories, gameMap);
+    // playerTurn(player, grid, gameMap);
 
     // comms
     bool acknowledge;
 
     // while the game is still going
     while (true) {
-        // wait for an Acknowledgement
-        do {
-            acknowledge = wait('A');
-            Serial.println("waiting");
-        } while(!acknowledge);
-
-        // sends an R
-        Serial3.println('R');
-        do
-        {
-            acknowledge = recievePoints(gameMap, territories, NUM_TERR);
-        } while (!acknowledge);
-        // sends an R
-        Serial3.print('R');
+        // waits for the other player's turn without blocking, so the map
+        // can still be panned in the meantime
+        while (!recievePoints(gameMap, territories, NUM_TERR, incoming, outgoing)) {
+            pollJoystick(gameMap);
+        }
+        reportLink(incoming, outgoing);
+#if DISPLAY_LIST
+        reportDisplayList(panel);
+#endif
 
         // redraws the map
-        drawAll(gameMap, territories, player);
+        drawAll(gameMap, player);
         sideBar(player);
 
         // main player turn
-        distribute(player, xSortedTerritories, gameMap);
-        playerTurn(player, xSortedTerritories, gameMap);
+        distribute(player, grid, gameMap);
+        playerTurn(player, grid, gameMap);
         //send the changes to the other player
         do {
-            acknowledge = handshake();
+            acknowledge = handshake(incoming, outgoing);
             Serial.println("handshake 1");
         } while (!acknowledge);
 
         do {
-            sendPoints(territories, NUM_TERR);
-            acknowledge = handshake();
+            // the changes go out while the side bar switches to the other player
+            sendBoard(territories, NUM_TERR, unsynced, incoming, outgoing);
+            sideBar(3 - player);
+            acknowledge = boardTaken(unsynced, incoming, outgoing);
             Serial.println("transmit");
         } while (!acknowledge);
     }
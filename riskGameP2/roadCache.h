@@ -0,0 +1,142 @@
+#ifndef _ROAD_CACHE_H
+#define _ROAD_CACHE_H
+
+#include <Arduino.h>
+#include "mapGraph.h"
+#include "viewport.h"
+
+/*
+  One road already clipped to a view, in screen coordinates.
+
+  A point in the 280x240 map area needs 17 bits, so two of them can't
+  fit in four bytes. The low bytes of the coordinates take four bytes
+  and the ninth bit of both x values shares a fifth.
+*/
+struct roadSegment {
+  uint8_t x0, y0, x1, y1;
+  uint8_t xHigh;
+
+  int16_t startX() const {
+    return x0 | ((xHigh & 1) << 8);
+  }
+
+  int16_t endX() const {
+    return x1 | ((xHigh & 2) << 7);
+  }
+};
+
+/*
+  The roads that show up in one view, deduplicated, clipped and in
+  screen coordinates, so drawing them is just streaming out the list.
+  update() only rebuilds the list when it is asked for a different view
+  or the map's roads have changed since it was built. The list keeps its
+  memory between views and only grows when a view shows more roads than
+  it has room for, so panning doesn't churn the heap.
+*/
+class roadCache {
+public:
+  roadCache() {
+    segments = NULL;
+    count = 0;
+    capacity = 0;
+    built = false;
+    version = 0;
+  }
+
+  ~roadCache() {
+    free(segments);
+  }
+
+  // makes sure the list matches the view and the map's roads
+  /*
+  Takes in:   map (the roads to list)
+              view (the part of the map the list is for)
+              centreX, centreY (where a road meets a territory, from its corner)
+  */
+  void update(masterMapGraph *map, const viewport &view, uint8_t centreX, uint8_t centreY) {
+    if (builtFor(view) && version == map->topologyVersion()) {
+      return;
+    }
+
+    count = clipRoads(map, view, centreX, centreY, segments, capacity);
+    if (count > capacity) {
+      // a quarter more, so the next view with a few more roads fits too.
+      // malloc, as it hands back NULL when the heap is full
+      free(segments);
+      capacity = count + count / 4;
+      segments = (roadSegment *) malloc(capacity * sizeof(roadSegment));
+      if (segments == NULL) {
+        // no roads rather than a list that isn't there, and the next
+        // call tries again
+        capacity = 0;
+        count = 0;
+        built = false;
+        return;
+      }
+      clipRoads(map, view, centreX, centreY, segments, capacity);
+    }
+
+    built = true;
+    builtView = view;
+    version = map->topologyVersion();
+  }
+
+  // checks if the list was built for this view
+  bool builtFor(const viewport &view) const {
+    return built && builtView.left == view.left && builtView.top == view.top
+        && builtView.width == view.width && builtView.height == view.height;
+  }
+
+  // the number of roads in the view
+  uint16_t size() const {
+    return count;
+  }
+
+  const roadSegment& operator[](uint16_t index) const {
+    return segments[index];
+  }
+
+private:
+  roadSegment *segments;
+  uint16_t count;
+  // how many segments fit in the list's memory
+  uint16_t capacity;
+  // which view and version of the roads the list was built from
+  bool built;
+  viewport builtView;
+  uint16_t version;
+
+  // clips every road to the view, returns how many are in it and stores
+  // the first room of them in out
+  uint16_t clipRoads(masterMapGraph *map, const viewport &view, uint8_t centreX, uint8_t centreY, roadSegment *out, uint16_t room) {
+    uint16_t found = 0;
+    for (int i = 0; i < map->size(); i++) {
+      for (masterMapGraph::NeighbourIterator j = map->neighbours(i); !map->isLastNeighbour(i, j); j = map->nextNeighbour(i, j)) {
+        // every road is listed under both of its territories
+        if (j.item().val < i) {
+          continue;
+        }
+
+        int16_t x0 = terrX(i) + centreX;
+        int16_t y0 = terrY(i) + centreY;
+        int16_t x1 = terrX(j.item().val) + centreX;
+        int16_t y1 = terrY(j.item().val) + centreY;
+        if (!view.clipLine(x0, y0, x1, y1)) {
+          continue;
+        }
+
+        if (found < room) {
+          out[found].x0 = x0 & 0xFF;
+          out[found].y0 = y0;
+          out[found].x1 = x1 & 0xFF;
+          out[found].y1 = y1;
+          out[found].xHigh = (x0 >> 8) | ((x1 >> 8) << 1);
+        }
+        found++;
+      }
+    }
+    return found;
+  }
+};
+
+#endif
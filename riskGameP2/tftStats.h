@@ -0,0 +1,266 @@
+#ifndef _TFT_STATS_H
+#define _TFT_STATS_H
+
+#include <Arduino.h>
+#include <Adafruit_ILI9341.h>
+
+/*
+  Define TFT_STATS to count what the sketch sends to the display. For
+  each call risk.cpp makes (fillRect, drawRect, drawLine, drawPixel,
+  writePixel, fillScreen and printed text) the driver adds up:
+    - the pixels that land on the screen
+    - the address windows set, the driver sets one per rectangle or
+      straight line, and one per pixel of a slanted line or a character
+    - the bytes that go over SPI for those, 11 per window (column and
+      page address commands plus the memory write command) and 2 per
+      pixel
+  Text is counted as whole 6x8 character cells, so it is an upper bound.
+
+  Without TFT_STATS the display is the plain driver and startFrame()
+  and reportFrame() do nothing.
+*/
+
+// SPI bytes to set an address window: CASET + 4, PASET + 4, RAMWR
+#define TFT_WINDOW_BYTES 11
+
+#ifdef TFT_STATS
+// the display driver with a running count of the pixels drawn
+class CountingILI9341 : public Adafruit_ILI9341 {
+public:
+  CountingILI9341(int8_t cs, int8_t dc) : Adafruit_ILI9341(cs, dc) {
+    resetCounts();
+    depth = 0;
+    textScale = 1;
+  }
+
+  // totals since the last resetCounts()
+  unsigned long pixelsDrawn() const {
+    return pixels;
+  }
+
+  unsigned long windowsSet() const {
+    return windows;
+  }
+
+  unsigned long spiBytes() const {
+    return bytes;
+  }
+
+  unsigned int drawCalls() const {
+    return calls;
+  }
+
+  void resetCounts() {
+    pixels = 0;
+    windows = 0;
+    bytes = 0;
+    calls = 0;
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (depth == 0) {
+      long area = clippedArea(x, y, 1, 1);
+      count(area, area);
+    }
+    depth++;
+    Adafruit_ILI9341::drawPixel(x, y, color);
+    depth--;
+  }
+
+  // same as drawPixel, but inside a startWrite()/endWrite() batch
+  void writePixel(int16_t x, int16_t y, uint16_t color) {
+    if (depth == 0) {
+      long area = clippedArea(x, y, 1, 1);
+      count(area, area);
+    }
+    depth++;
+    Adafruit_ILI9341::writePixel(x, y, color);
+    depth--;
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (depth == 0) {
+      long area = clippedArea(x, y, w, h);
+      count(area, area > 0 ? 1 : 0);
+    }
+    depth++;
+    Adafruit_ILI9341::fillRect(x, y, w, h, color);
+    depth--;
+  }
+
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    if (depth == 0) {
+      // the outline is the rectangle minus its inside, drawn as 4 lines
+      long area = clippedArea(x, y, w, h) - clippedArea(x + 1, y + 1, w - 2, h - 2);
+      count(area, area > 0 ? 4 : 0);
+    }
+    depth++;
+    Adafruit_ILI9341::drawRect(x, y, w, h, color);
+    depth--;
+  }
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (depth == 0) {
+      long length = clippedLine(x0, y0, x1, y1);
+      if (x0 == x1 || y0 == y1) {
+        count(length, length > 0 ? 1 : 0);
+      }
+      else {
+        // slanted lines go out one pixel at a time
+        count(length, length);
+      }
+    }
+    depth++;
+    Adafruit_ILI9341::drawLine(x0, y0, x1, y1, color);
+    depth--;
+  }
+
+  void fillScreen(uint16_t color) {
+    if (depth == 0) {
+      count((long) width() * height(), 1);
+    }
+    depth++;
+    Adafruit_ILI9341::fillScreen(color);
+    depth--;
+  }
+
+  // every character the sketch prints goes through here
+  size_t write(uint8_t c) {
+    if (depth == 0 && c != '\n' && c != '\r') {
+      // each font pixel is its own window, a square of textScale pixels
+      long area = clippedArea(getCursorX(), getCursorY(), 6 * textScale, 8 * textScale);
+      count(area, area / (textScale * textScale));
+    }
+    depth++;
+    size_t written = Adafruit_ILI9341::write(c);
+    depth--;
+    return written;
+  }
+  using Print::write;
+
+  // the library doesn't let us read the text size back, so keep a copy
+  void setTextSize(uint8_t s) {
+    textScale = s;
+    Adafruit_ILI9341::setTextSize(s);
+  }
+
+private:
+  unsigned long pixels, windows, bytes;
+  unsigned int calls;
+  // how many of our drawing calls are running, only the outermost one
+  // counts when the library draws a shape out of other shapes
+  uint8_t depth;
+  uint8_t textScale;
+
+  void count(long area, long newWindows) {
+    pixels += area;
+    windows += newWindows;
+    bytes += newWindows * TFT_WINDOW_BYTES + 2 * area;
+    calls++;
+  }
+
+  // the area of a rectangle that lands on the screen
+  long clippedArea(long x, long y, long w, long h) {
+    long x1 = min(x + w, (long) width());
+    long y1 = min(y + h, (long) height());
+    x = max(x, 0L);
+    y = max(y, 0L);
+    if (x1 <= x || y1 <= y) {
+      return 0;
+    }
+    return (x1 - x) * (y1 - y);
+  }
+
+  // narrows [first, last] to the steps i of a line where
+  // start + i*delta/steps stays within [0, limit)
+  static void clipSteps(long start, long delta, long steps, long limit, long &first, long &last) {
+    if (delta == 0) {
+      if (start < 0 || start >= limit) {
+        last = first - 1;
+      }
+      return;
+    }
+    long low, high;
+    if (delta > 0) {
+      low = divCeil(-start * steps, delta);
+      high = divFloor((limit - 1 - start) * steps, delta);
+    }
+    else {
+      low = divCeil((limit - 1 - start) * steps, delta);
+      high = divFloor(-start * steps, delta);
+    }
+    first = max(first, low);
+    last = min(last, high);
+  }
+
+  static long divFloor(long a, long b) {
+    long q = a / b;
+    return (q * b != a && (a < 0) != (b < 0)) ? q - 1 : q;
+  }
+
+  static long divCeil(long a, long b) {
+    return -divFloor(-a, b);
+  }
+
+  // the number of pixels of a line that land on the screen
+  long clippedLine(long x0, long y0, long x1, long y1) {
+    long steps = max(abs(x1 - x0), abs(y1 - y0));
+    if (steps == 0) {
+      return clippedArea(x0, y0, 1, 1);
+    }
+    long first = 0, last = steps;
+    clipSteps(x0, x1 - x0, steps, width(), first, last);
+    clipSteps(y0, y1 - y0, steps, height(), first, last);
+    return (last >= first) ? last - first + 1 : 0;
+  }
+};
+
+typedef CountingILI9341 Display;
+#else
+typedef Adafruit_ILI9341 Display;
+#endif
+
+#ifdef TFT_STATS
+// when the current frame started
+unsigned long frameStart;
+#endif
+
+// starts counting a new frame
+/*
+Takes in:   display (the screen, only used when TFT_STATS is defined)
+
+Returns:    Nothing
+*/
+void startFrame(Display &display) {
+#ifdef TFT_STATS
+  display.resetCounts();
+  frameStart = micros();
+#endif
+}
+
+// prints what was sent to the display since startFrame(), and how long it took
+/*
+Takes in:   display (the screen, only used when TFT_STATS is defined)
+            label (printed in front of the numbers)
+
+Returns:    Nothing
+*/
+void reportFrame(Display &display, const char *label) {
+#ifdef TFT_STATS
+  unsigned long elapsed = micros() - frameStart;
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print(display.drawCalls());
+  Serial.print(" calls, ");
+  Serial.print(display.pixelsDrawn());
+  Serial.print(" pixels, ");
+  Serial.print(display.windowsSet());
+  Serial.print(" windows, ");
+  Serial.print(display.spiBytes());
+  Serial.print(" SPI bytes in ");
+  Serial.print(elapsed);
+  Serial.println(" us");
+#endif
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+  Times makeMap() on each map and counts the heap it uses while loading:
+  every allocation made with new, and the most bytes held at once.
+  Strings use malloc() like the core's and aren't counted. The byte
+  counts are the host's (8 byte pointers), so they only compare with
+  each other.
+
+  Usage: build_bench mapdir...
+*/
+
+#include "readFile.h"
+#include "heapCount.h"
+
+territory *territories;
+
+int main(int argc, char **argv) {
+  printf("territories  allocations  peak heap (bytes)  build time\n");
+  for (int i = 1; i < argc; ++i) {
+    SD.root = argv[i];
+    // the first load warms up the file cache
+    delete makeMap(territories);
+    delete[] territories;
+
+    long allocationsBefore = heapAllocations;
+    heapPeak = heapBytes;
+    long bytesBefore = heapBytes;
+    unsigned long start = micros();
+    masterMapGraph *map = makeMap(territories);
+    unsigned long elapsed = micros() - start;
+    printf("%11d  %11ld  %17ld  %7lu us\n", map->size(), heapAllocations - allocationsBefore,
+           heapPeak - bytesBefore, elapsed);
+    delete map;
+    delete[] territories;
+  }
+  return 0;
+}
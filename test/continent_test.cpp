@@ -0,0 +1,97 @@
+/*
+  Flips random territories between the teams and checks
+  continentBonus() and flip()'s completed continent against a scan of
+  every territory after each flip. Then times continentBonus() against
+  that scan.
+
+  Usage: continent_test mapdir...
+*/
+
+#include "readFile.h"
+#include <time.h>
+
+territory *territories;
+
+// the bonus worked out from scratch, the way the sketch used to
+static int scan(int team, int count, int conts) {
+  int bonus = 0;
+  for (int c = 0; c < conts; ++c) {
+    int members = 0;
+    bool owned = true;
+    for (int i = 0; i < count; ++i) {
+      if (terrCont(i) == c) {
+        members++;
+        owned = owned && territories[i].team == team;
+      }
+    }
+    if (owned) {
+      bonus += members;
+    }
+  }
+  for (int i = 0; i < count; ++i) {
+    if (territories[i].team == team && terrType(i) == 4) {
+      bonus += terrMagnitude(i);
+    }
+  }
+  return bonus;
+}
+
+static double seconds() {
+  return clock() / (double) CLOCKS_PER_SEC;
+}
+
+static int check(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map = makeMap(territories);
+  int count = map->size(), conts = 0;
+  for (int i = 0; i < count; ++i) {
+    conts = max(conts, terrCont(i) + 1);
+  }
+
+  srand(1);
+  int wrong = 0, captures = 0;
+  for (int k = 0; k < 10000; ++k) {
+    int id = rand() % count;
+    territories[id].team = 3 - territories[id].team;
+    int completed = map->flip(territories[id]);
+    if (completed >= 0) {
+      captures++;
+      bool owned = completed == terrCont(id);
+      for (int i = 0; i < count; ++i) {
+        if (terrCont(i) == completed && territories[i].team != territories[id].team) {
+          owned = false;
+        }
+      }
+      wrong += !owned;
+    }
+    for (int team = 1; team <= 2; ++team) {
+      wrong += map->continentBonus(team) != scan(team, count, conts);
+    }
+  }
+
+  volatile long sum = 0;
+  double start = seconds();
+  for (long k = 0; k < 1000000; ++k) {
+    sum += map->continentBonus(1 + (k & 1));
+  }
+  double counted = (seconds() - start) * 1e3;
+  start = seconds();
+  for (long k = 0; k < 100000; ++k) {
+    sum += scan(1 + (k & 1), count, conts);
+  }
+  double scanned = (seconds() - start) * 1e4;
+
+  printf("%s: 10000 flips (%d continents completed), %d wrong, continentBonus %.1f ns, scan %.1f ns\n",
+         dir, captures, wrong, counted, scanned);
+  delete map;
+  delete[] territories;
+  return wrong > 0;
+}
+
+int main(int argc, char **argv) {
+  int failed = 0;
+  for (int i = 1; i < argc; ++i) {
+    failed += check(argv[i]);
+  }
+  return failed > 0;
+}
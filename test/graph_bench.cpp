@@ -0,0 +1,94 @@
+/*
+  Times walking every territory's neighbours on each map, the loop the
+  sketch runs to draw the roads, and isNeighbour() on pairs of
+  territories, half of them joined by a road, the check every attack
+  makes. Uses whichever MAP_ADJACENCY backend it was built with. 'make bench' builds it once per backend, like
+  graph_test. Host timings only compare with each other, an AVR is far
+  slower and has no cache.
+
+  Usage: graph_bench mapdir...
+*/
+
+#include "readFile.h"
+#include <time.h>
+
+#if MAP_ADJACENCY == ADJ_CSR
+#define BACKEND "ADJ_CSR"
+#elif MAP_ADJACENCY == ADJ_BITSET
+#define BACKEND "ADJ_BITSET"
+#elif defined(MAP_FLAT_SETS)
+#define BACKEND "ADJ_HASH, FlatHashSet"
+#else
+#define BACKEND "ADJ_HASH"
+#endif
+
+// how many times the whole map is walked
+#define WALKS 20000
+// how many pairs isNeighbour() is asked about, each 10 times
+#define LOOKUPS 200000
+
+territory *territories;
+
+static double seconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void bench(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map = makeMap(territories);
+  int count = map->size();
+
+  volatile long sum = 0;
+  long roads = 0;
+  double start = seconds();
+  for (int w = 0; w < WALKS; ++w) {
+    for (int t = 0; t < count; ++t) {
+      for (masterMapGraph::NeighbourIterator i = map->neighbours(t); !map->isLastNeighbour(t, i); i = map->nextNeighbour(t, i)) {
+        sum += i.item().val;
+        roads++;
+      }
+    }
+  }
+  double walked = (seconds() - start) * 1e9;
+
+  // half the pairs are a territory and one of its neighbours
+  uint8_t *from = new uint8_t[LOOKUPS];
+  uint8_t *to = new uint8_t[LOOKUPS];
+  srand(1);
+  for (int k = 0; k < LOOKUPS; ++k) {
+    from[k] = rand() % count;
+    to[k] = rand() % count;
+    if (k % 2 == 0 && map->numNeighbours(from[k]) > 0) {
+      int pick = rand() % map->numNeighbours(from[k]);
+      masterMapGraph::NeighbourIterator i = map->neighbours(from[k]);
+      for (; pick > 0; --pick) {
+        i = map->nextNeighbour(from[k], i);
+      }
+      to[k] = i.item().val;
+    }
+  }
+  start = seconds();
+  for (int r = 0; r < 10; ++r) {
+    for (int k = 0; k < LOOKUPS; ++k) {
+      sum += map->isNeighbour(from[k], to[k]);
+    }
+  }
+  double looked = (seconds() - start) * 1e9 / (10.0 * LOOKUPS);
+
+  printf("%11d  %11.1f us  %8.1f ns  %11.1f ns\n", count, walked / WALKS / 1000, walked / roads, looked);
+  delete[] from;
+  delete[] to;
+  delete map;
+  delete[] territories;
+}
+
+int main(int argc, char **argv) {
+  printf("%s\n", BACKEND);
+  printf("territories  walk the map  per road  isNeighbour\n");
+  for (int i = 1; i < argc; ++i) {
+    bench(argv[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+  Loads each map with makeMap() and checks the map graph against the
+  roads listed in the file: every territory has exactly the neighbours
+  the P lines give it, once each, whichever MAP_ADJACENCY backend it
+  was built with. Also prints the heap the loaded map holds on to.
+
+  Usage: graph_test mapdir... (each directory holds a map.txt)
+*/
+
+#include "readFile.h"
+#include "heapCount.h"
+#include <set>
+#include <utility>
+
+territory *territories;
+
+// the roads straight from the file, both ways round
+static bool readRoads(const char *dir, int &count, std::set<std::pair<int, int> > &roads) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/map.txt", dir);
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return false;
+  }
+  int edges, conts;
+  if (fscanf(file, "B %d %d %d\n", &count, &edges, &conts) != 3) {
+    fclose(file);
+    return false;
+  }
+  char line[128];
+  while (fgets(line, sizeof(line), file)) {
+    int from, to;
+    if (sscanf(line, "P %d %d", &from, &to) == 2) {
+      roads.insert(std::make_pair(from, to));
+      roads.insert(std::make_pair(to, from));
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+static int check(const char *dir) {
+  int count;
+  std::set<std::pair<int, int> > roads;
+  if (!readRoads(dir, count, roads)) {
+    printf("%s: can't read map.txt\n", dir);
+    return 1;
+  }
+
+  SD.root = dir;
+  long blocksBefore = heapBlocks, bytesBefore = heapBytes;
+  masterMapGraph *map = makeMap(territories);
+  long mapBlocks = heapBlocks - blocksBefore, mapBytes = heapBytes - bytesBefore;
+
+  int wrong = 0;
+  if (map->size() != count) {
+    printf("%s: %d territories loaded, the file has %d\n", dir, map->size(), count);
+    return 1;
+  }
+  for (int t = 0; t < count; ++t) {
+    std::set<int> seen;
+    for (masterMapGraph::NeighbourIterator i = map->neighbours(t); !map->isLastNeighbour(t, i); i = map->nextNeighbour(t, i)) {
+      int u = i.item().val;
+      if (!seen.insert(u).second || !roads.count(std::make_pair(t, u))) {
+        wrong++;
+      }
+    }
+    int expected = 0;
+    for (int u = 0; u < count; ++u) {
+      bool road = roads.count(std::make_pair(t, u)) > 0;
+      expected += road;
+      if (map->isNeighbour(t, u) != road) {
+        wrong++;
+      }
+    }
+    if ((int) seen.size() != expected || map->numNeighbours(t) != expected) {
+      wrong++;
+    }
+  }
+
+  printf("%s: %d territories, %d roads, %ld heap blocks (%ld bytes) held, %d wrong\n",
+         dir, count, (int) roads.size() / 2, mapBlocks, mapBytes, wrong);
+  delete map;
+  delete[] territories;
+  return wrong > 0;
+}
+
+int main(int argc, char **argv) {
+  int failed = 0;
+  for (int i = 1; i < argc; ++i) {
+    failed += check(argv[i]);
+  }
+  return failed > 0;
+}
@@ -0,0 +1,58 @@
+#ifndef _HEAP_COUNT_H
+#define _HEAP_COUNT_H
+
+/*
+  Counts the program's heap use by wrapping operator new and delete.
+  Include it in one file of a test only.
+*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
+
+// blocks and bytes held right now, the most bytes ever held, and every
+// allocation made
+long heapBlocks = 0, heapBytes = 0, heapPeak = 0, heapAllocations = 0;
+
+void* operator new(size_t size) {
+  size_t *block = (size_t *) malloc(size + sizeof(max_align_t));
+  if (block == NULL) {
+    throw std::bad_alloc();
+  }
+  *block = size;
+  heapBlocks++;
+  heapAllocations++;
+  heapBytes += size;
+  if (heapBytes > heapPeak) {
+    heapPeak = heapBytes;
+  }
+  return (char *) block + sizeof(max_align_t);
+}
+
+void operator delete(void *p) noexcept {
+  if (p == NULL) {
+    return;
+  }
+  size_t *block = (size_t *) ((uintptr_t) p - sizeof(max_align_t));
+  heapBlocks--;
+  heapBytes -= *block;
+  free(block);
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete[](void *p) noexcept {
+  operator delete(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef _ADAFRUIT_GFX_H
+#define _ADAFRUIT_GFX_H
+
+#include <Arduino.h>
+
+/*
+  Stand-in for the Adafruit GFX library. The shapes are built out of one
+  another the way the library builds them: a rectangle outline is four
+  straight lines, a straight line is a thin filled rectangle, and a
+  slanted line or a character goes out a pixel (or a text size square)
+  at a time. So a driver that overrides some of them, like the
+  CountingILI9341 in tftStats.h, sees the same calls as on the board.
+
+  The font is not the library's. Each character is a 5x7 pattern made
+  up from its code, in the library's 6x8 cell, so text lands where it
+  would on the board but doesn't read as letters.
+*/
+class Adafruit_GFX : public Print {
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {
+    _width = w;
+    _height = h;
+    rotation = 0;
+    cursor_x = cursor_y = 0;
+    textsize = 1;
+    textcolor = textbgcolor = 0xFFFF;
+    wrap = true;
+  }
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+  virtual void startWrite() {}
+  virtual void writePixel(int16_t x, int16_t y, uint16_t color) {
+    drawPixel(x, y, color);
+  }
+  virtual void endWrite() {}
+
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    startWrite();
+    for (int16_t j = y; j < y + h; ++j) {
+      for (int16_t i = x; i < x + w; ++i) {
+        writePixel(i, j, color);
+      }
+    }
+    endWrite();
+  }
+
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillRect(x, y, w, 1, color);
+  }
+
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillRect(x, y, 1, h, color);
+  }
+
+  virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+  }
+
+  // the library's Bresenham, so slanted lines hit the same pixels
+  virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (x0 == x1) {
+      drawFastVLine(x0, min(y0, y1), abs(y1 - y0) + 1, color);
+      return;
+    }
+    if (y0 == y1) {
+      drawFastHLine(min(x0, x1), y0, abs(x1 - x0) + 1, color);
+      return;
+    }
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+      swap(x0, y0);
+      swap(x1, y1);
+    }
+    if (x0 > x1) {
+      swap(x0, x1);
+      swap(y0, y1);
+    }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = (y0 < y1) ? 1 : -1;
+
+    startWrite();
+    for (; x0 <= x1; ++x0) {
+      if (steep) {
+        writePixel(y0, x0, color);
+      }
+      else {
+        writePixel(x0, y0, color);
+      }
+      err -= dy;
+      if (err < 0) {
+        y0 += ystep;
+        err += dx;
+      }
+    }
+    endWrite();
+  }
+
+  virtual void fillScreen(uint16_t color) {
+    fillRect(0, 0, _width, _height, color);
+  }
+
+  virtual size_t write(uint8_t c) {
+    if (c == '\n') {
+      cursor_x = 0;
+      cursor_y += textsize * 8;
+    }
+    else if (c != '\r') {
+      if (wrap && cursor_x + textsize * 6 > _width) {
+        cursor_x = 0;
+        cursor_y += textsize * 8;
+      }
+      drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize);
+      cursor_x += textsize * 6;
+    }
+    return 1;
+  }
+  using Print::write;
+
+  // the background is only drawn if it differs from the color, like
+  // the library's setTextColor(color) leaving it transparent
+  void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size) {
+    if (x >= _width || y >= _height || x + 6 * size - 1 < 0 || y + 8 * size - 1 < 0) {
+      return;
+    }
+    startWrite();
+    for (int8_t i = 0; i < 6; ++i) {
+      uint8_t line = glyphColumn(c, i);
+      for (int8_t j = 0; j < 8; ++j, line >>= 1) {
+        if (!(line & 1) && bg == color) {
+          continue;
+        }
+        uint16_t pen = (line & 1) ? color : bg;
+        if (size == 1) {
+          writePixel(x + i, y + j, pen);
+        }
+        else {
+          fillRect(x + i * size, y + j * size, size, size, pen);
+        }
+      }
+    }
+    endWrite();
+  }
+
+  void setCursor(int16_t x, int16_t y) {
+    cursor_x = x;
+    cursor_y = y;
+  }
+
+  int16_t getCursorX() const {
+    return cursor_x;
+  }
+
+  int16_t getCursorY() const {
+    return cursor_y;
+  }
+
+  void setTextSize(uint8_t s) {
+    textsize = (s > 0) ? s : 1;
+  }
+
+  void setTextColor(uint16_t c) {
+    textcolor = textbgcolor = c;
+  }
+
+  void setTextColor(uint16_t c, uint16_t bg) {
+    textcolor = c;
+    textbgcolor = bg;
+  }
+
+  void setTextWrap(bool w) {
+    wrap = w;
+  }
+
+  virtual void setRotation(uint8_t r) {
+    rotation = r & 3;
+    _width = (rotation & 1) ? HEIGHT : WIDTH;
+    _height = (rotation & 1) ? WIDTH : HEIGHT;
+  }
+
+  uint8_t getRotation() const {
+    return rotation;
+  }
+
+  int16_t width() const {
+    return _width;
+  }
+
+  int16_t height() const {
+    return _height;
+  }
+
+protected:
+  const int16_t WIDTH, HEIGHT;
+  int16_t _width, _height;
+  int16_t cursor_x, cursor_y;
+  uint16_t textcolor, textbgcolor;
+  uint8_t textsize, rotation;
+  bool wrap;
+
+private:
+  // column i of character c, bit j set if row j is lit (the bottom row
+  // and the column after the character are always blank)
+  static uint8_t glyphColumn(unsigned char c, int8_t i) {
+    if (c == ' ' || i == 5) {
+      return 0;
+    }
+    return (uint8_t) ((c * 37 + i * 101 + c * i * 13) & 0x7F);
+  }
+
+  static void swap(int16_t &a, int16_t &b) {
+    int16_t t = a;
+    a = b;
+    b = t;
+  }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef _ADAFRUIT_ILI9341_H
+#define _ADAFRUIT_ILI9341_H
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "Adafruit_GFX.h"
+
+#define ILI9341_TFTWIDTH 240
+#define ILI9341_TFTHEIGHT 320
+
+#define ILI9341_BLACK 0x0000
+#define ILI9341_BLUE 0x001F
+#define ILI9341_RED 0xF800
+#define ILI9341_GREEN 0x07E0
+#define ILI9341_CYAN 0x07FF
+#define ILI9341_MAGENTA 0xF81F
+#define ILI9341_YELLOW 0xFFE0
+#define ILI9341_WHITE 0xFFFF
+
+/*
+  Stand-in for the display driver. It draws into the panel's memory, an
+  RGB565 framebuffer in portrait like the real one, and setRotation()
+  only changes how coordinates land in it.
+
+  Host only: pixel() reads the screen back at the current rotation and
+  savePPM() writes it out as an image. The driver also counts what it
+  would have sent over SPI, the same way tftStats.h estimates it: one
+  address window per rectangle or pixel that lands on the screen, 11
+  bytes to set it and 2 bytes per pixel. These are totals since
+  resetBus(), tftStats.h's counts can be checked against them.
+*/
+class Adafruit_ILI9341 : public Adafruit_GFX {
+public:
+  Adafruit_ILI9341(int8_t cs, int8_t dc, int8_t rst = -1)
+    : Adafruit_GFX(ILI9341_TFTWIDTH, ILI9341_TFTHEIGHT) {
+    memset(panel, 0, sizeof(panel));
+    resetBus();
+  }
+
+  void begin(uint32_t freq = 0) {
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) {
+    if (x >= 0 && y >= 0 && x < _width && y < _height) {
+      busWindows++;
+      busPixels++;
+      panel[index(x, y)] = color;
+    }
+  }
+
+  void writePixel(int16_t x, int16_t y, uint16_t color) {
+    drawPixel(x, y, color);
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    int16_t x1 = min<int32_t>(x + w, _width);
+    int16_t y1 = min<int32_t>(y + h, _height);
+    x = max<int16_t>(x, 0);
+    y = max<int16_t>(y, 0);
+    if (x1 <= x || y1 <= y) {
+      return;
+    }
+    busWindows++;
+    busPixels += (unsigned long) (x1 - x) * (y1 - y);
+    for (int16_t j = y; j < y1; ++j) {
+      for (int16_t i = x; i < x1; ++i) {
+        panel[index(i, j)] = color;
+      }
+    }
+  }
+
+  // host only
+  uint16_t pixel(int16_t x, int16_t y) const {
+    return panel[index(x, y)];
+  }
+
+  unsigned long busBytes() const {
+    return busWindows * 11 + busPixels * 2;
+  }
+
+  void resetBus() {
+    busPixels = 0;
+    busWindows = 0;
+  }
+
+  // writes the screen as a binary PPM, false if the file can't be written
+  bool savePPM(const char *path) const {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+      return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+    for (int16_t y = 0; y < _height; ++y) {
+      for (int16_t x = 0; x < _width; ++x) {
+        uint16_t c = pixel(x, y);
+        uint8_t rgb[3] = {
+          (uint8_t) (((c >> 11) & 0x1F) * 255 / 31),
+          (uint8_t) (((c >> 5) & 0x3F) * 255 / 63),
+          (uint8_t) ((c & 0x1F) * 255 / 31)
+        };
+        fwrite(rgb, 1, 3, file);
+      }
+    }
+    return fclose(file) == 0;
+  }
+
+  unsigned long busPixels, busWindows;
+
+private:
+  uint16_t panel[ILI9341_TFTWIDTH * ILI9341_TFTHEIGHT];
+
+  // where a point on the screen is in the panel's memory
+  int32_t index(int16_t x, int16_t y) const {
+    switch (rotation) {
+      case 0: return (int32_t) y * WIDTH + x;
+      case 1: return (int32_t) x * WIDTH + (WIDTH - 1 - y);
+      case 2: return (int32_t) (HEIGHT - 1 - y) * WIDTH + (WIDTH - 1 - x);
+      default: return (int32_t) (HEIGHT - 1 - x) * WIDTH + y;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+/*
+  Just enough of the Arduino 1.0 core to build the sketch's headers on a
+  PC, for the tests in this directory. Only what the sketch calls is
+  here, with the same signatures as the 1.0 core, so code that needs a
+  newer core (e.g. HardwareSerial::availableForWrite) fails here too.
+
+  Host only additions are marked as such.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "avr/pgmspace.h"
+
+// the core's min/max are macros, templates are stricter about mixing
+// types, so whatever builds here builds there
+using std::min;
+using std::max;
+
+// like the core's, so an argument with side effects (e.g. an
+// analogRead) runs twice here as well
+#ifdef abs
+#undef abs
+#endif
+#define abs(x) ((x)>0?(x):-(x))
+
+template <typename T, typename L, typename H>
+T constrain(T amount, L low, H high) {
+  return amount < low ? low : (amount > high ? high : amount);
+}
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+
+#define DEC 10
+#define HEX 16
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void init();
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+// host only: what analogRead and digitalRead return for each pin, the
+// analog pins start centred (512) and the digital ones HIGH
+extern int hostPinValue[70];
+// host only: how many times analogRead has been called
+extern unsigned long hostAnalogReads;
+
+class String {
+public:
+  String(const char *text = "");
+  String(const String &other);
+  ~String();
+  String& operator=(const String &other);
+  String& operator+=(char c);
+  const char* c_str() const {
+    return text;
+  }
+  long toInt() const;
+
+private:
+  char *text;
+  unsigned int length;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str);
+
+  size_t print(const char text[]);
+  size_t print(const String &text);
+  size_t print(char c);
+  size_t print(unsigned char n, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println(const char text[]);
+  size_t println(const String &text);
+  size_t println(char c);
+  size_t println(unsigned char n, int base = DEC);
+  size_t println(int n, int base = DEC);
+  size_t println(unsigned int n, int base = DEC);
+  size_t println(long n, int base = DEC);
+  size_t println(unsigned long n, int base = DEC);
+  size_t println(double n, int digits = 2);
+  size_t println(void);
+
+private:
+  size_t printNumber(unsigned long n, uint8_t base);
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+};
+
+/*
+  A serial port. Without attach() it sends nowhere and never receives,
+  except that Serial prints on stderr when HOST_SERIAL is set.
+
+  Host only: attach() connects the port to a file descriptor, e.g. one
+  end of a pseudo-terminal. Every byte then goes over as two, the baud
+  rate it was sent at (in units of 2400) and the byte, so the far end
+  can garble bytes that were sent at another rate than it reads at, like
+  a real UART would. Bytes sent faster than noisyAbove get a bit flipped
+  one time in eight. What was sent before the first begin() is
+  dropped, the port wasn't listening yet.
+*/
+class HardwareSerial : public Stream {
+public:
+  HardwareSerial();
+  void begin(unsigned long baud);
+  void end();
+  virtual int available();
+  virtual int peek();
+  virtual int read();
+  virtual void flush();
+  virtual size_t write(uint8_t c);
+  using Print::write;
+  operator bool() {
+    return true;
+  }
+
+  // host only, the descriptor has to be non-blocking
+  void attach(int fd);
+  unsigned long baud() const {
+    return rate;
+  }
+  // bytes sent faster than this are corrupted now and then (0 for never)
+  unsigned long noisyAbove;
+  // bytes written, and bytes that came in at the wrong rate or corrupted
+  unsigned long written, garbled;
+  bool echo;
+
+private:
+  int fd;
+  unsigned long rate;
+  // a byte that was read ahead by peek(), -1 if none
+  int ahead;
+  // the rate half of a pair that has come in without its byte (-1 if none)
+  int half;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial3;
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef _HOST_SD_H
+#define _HOST_SD_H
+
+#include <Arduino.h>
+
+#define FILE_READ 0
+
+// a file on the PC, read only
+class File {
+public:
+  File(FILE *file = NULL);
+  int read();
+  int peek();
+  int available();
+  uint32_t position();
+  bool seek(uint32_t position);
+  void close();
+  operator bool() const {
+    return file != NULL;
+  }
+
+private:
+  FILE *file;
+};
+
+// host only: the card is a directory on the PC, root (the working
+// directory if it isn't set)
+class SDClass {
+public:
+  SDClass() : root(".") {}
+  bool begin(uint8_t csPin);
+  File open(const char *name, uint8_t mode = FILE_READ);
+
+  const char *root;
+};
+
+extern SDClass SD;
+
+#endif
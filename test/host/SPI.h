@@ -0,0 +1,7 @@
+#ifndef _HOST_SPI_H
+#define _HOST_SPI_H
+
+// the display and SD card stand-ins don't talk SPI
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _TOUCHSCREEN_H
+#define _TOUCHSCREEN_H
+
+#include <Arduino.h>
+
+class TSPoint {
+public:
+  TSPoint() : x(0), y(0), z(0) {}
+  TSPoint(int16_t x, int16_t y, int16_t z) : x(x), y(y), z(z) {}
+  int16_t x, y, z;
+};
+
+/*
+  Stand-in for the resistive touch screen. Nothing touches it unless a
+  test does.
+
+  Host only: press is returned by the next getPoint(), then the screen
+  reads as untouched again.
+*/
+class TouchScreen {
+public:
+  TouchScreen(uint8_t xp, uint8_t yp, uint8_t xm, uint8_t ym, uint16_t rxplate = 0) {}
+
+  TSPoint getPoint() {
+    TSPoint point = press;
+    press = TSPoint();
+    return point;
+  }
+
+  TSPoint press;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _HOST_PGMSPACE_H
+#define _HOST_PGMSPACE_H
+
+// the host has one address space, so "flash" is plain memory
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+#define pgm_read_dword(address) (*(const uint32_t *) (address))
+
+#endif
@@ -0,0 +1,366 @@
+/*
+  The host side of the Arduino stand-ins in this directory.
+*/
+
+#include <Arduino.h>
+#include <SD.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <errno.h>
+
+HardwareSerial Serial;
+HardwareSerial Serial3;
+SDClass SD;
+
+int hostPinValue[70];
+unsigned long hostAnalogReads = 0;
+
+// sets the pins up and starts the clock before main() runs
+static struct HostStart {
+  HostStart() {
+    for (int i = 0; i < 70; ++i) {
+      hostPinValue[i] = (i >= A0) ? 512 : HIGH;
+    }
+    Serial.echo = getenv("HOST_SERIAL") != NULL;
+    micros();
+  }
+} hostStart;
+
+unsigned long micros() {
+  static struct timeval start;
+  static bool started = false;
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  if (!started) {
+    start = now;
+    started = true;
+  }
+  return (now.tv_sec - start.tv_sec) * 1000000UL + now.tv_usec - start.tv_usec;
+}
+
+unsigned long millis() {
+  return micros() / 1000;
+}
+
+void delay(unsigned long ms) {
+  usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  usleep(us);
+}
+
+void init() {
+}
+
+long random(long howBig) {
+  return howBig > 0 ? rand() % howBig : 0;
+}
+
+long random(long howSmall, long howBig) {
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) {
+  srand(seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+}
+
+int digitalRead(uint8_t pin) {
+  return hostPinValue[pin];
+}
+
+int analogRead(uint8_t pin) {
+  hostAnalogReads++;
+  // the core takes 0-7 for A0-A7 as well
+  return hostPinValue[pin < A0 ? pin + A0 : pin];
+}
+
+// like the core, the text lives in malloc()ed memory that is
+// realloc()ed as it grows
+String::String(const char *text) {
+  length = strlen(text);
+  this->text = (char *) malloc(length + 1);
+  strcpy(this->text, text);
+}
+
+String::String(const String &other) {
+  length = other.length;
+  text = (char *) malloc(length + 1);
+  strcpy(text, other.text);
+}
+
+String::~String() {
+  free(text);
+}
+
+String& String::operator=(const String &other) {
+  if (this != &other) {
+    length = other.length;
+    text = (char *) realloc(text, length + 1);
+    strcpy(text, other.text);
+  }
+  return *this;
+}
+
+String& String::operator+=(char c) {
+  text = (char *) realloc(text, length + 2);
+  text[length++] = c;
+  text[length] = '\0';
+  return *this;
+}
+
+long String::toInt() const {
+  return atol(text);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::write(const char *str) {
+  return write((const uint8_t *) str, strlen(str));
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char digits[8 * sizeof(long) + 1];
+  char *at = digits + sizeof(digits) - 1;
+  *at = '\0';
+  do {
+    uint8_t digit = n % base;
+    *--at = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n > 0);
+  return write(at);
+}
+
+size_t Print::print(const char text[]) {
+  return write(text);
+}
+
+size_t Print::print(const String &text) {
+  return write(text.c_str());
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t) c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+  return print((unsigned long) n, base);
+}
+
+size_t Print::print(int n, int base) {
+  return print((long) n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long) n, base);
+}
+
+size_t Print::print(long n, int base) {
+  // like the core, only base 10 prints a sign
+  if (base == DEC && n < 0) {
+    return print('-') + printNumber(-n, DEC);
+  }
+  return printNumber((unsigned long) n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", digits, n);
+  return write(text);
+}
+
+size_t Print::println(void) {
+  return write("\r\n");
+}
+
+size_t Print::println(const char text[]) {
+  return print(text) + println();
+}
+
+size_t Print::println(const String &text) {
+  return print(text) + println();
+}
+
+size_t Print::println(char c) {
+  return print(c) + println();
+}
+
+size_t Print::println(unsigned char n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(int n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(unsigned int n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(long n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(double n, int digits) {
+  return print(n, digits) + println();
+}
+
+HardwareSerial::HardwareSerial() {
+  noisyAbove = 0;
+  written = 0;
+  garbled = 0;
+  echo = false;
+  fd = -1;
+  rate = 0;
+  ahead = -1;
+  half = -1;
+}
+
+void HardwareSerial::attach(int fd) {
+  this->fd = fd;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+  // the UART wasn't on before the first begin(), so nothing sent until
+  // now reached it
+  uint8_t in;
+  while (rate == 0 && fd >= 0 && ::read(fd, &in, 1) == 1) {
+  }
+  rate = baud;
+}
+
+void HardwareSerial::end() {
+  // like the core, whatever hasn't been read yet is dropped
+  while (read() >= 0) {
+  }
+}
+
+void HardwareSerial::flush() {
+}
+
+int HardwareSerial::available() {
+  return peek() >= 0 ? 1 : 0;
+}
+
+int HardwareSerial::peek() {
+  if (ahead >= 0 || fd < 0) {
+    return ahead;
+  }
+  uint8_t in;
+  while (::read(fd, &in, 1) == 1) {
+    if (half < 0) {
+      half = in;
+      continue;
+    }
+    if ((unsigned long) half * 2400 != rate) {
+      // a UART reading at the wrong rate sees some other byte
+      in = (uint8_t) (in * 13 + 0x3B) ^ 0xC6;
+      garbled++;
+    }
+    half = -1;
+    ahead = in;
+    break;
+  }
+  return ahead;
+}
+
+int HardwareSerial::read() {
+  int c = peek();
+  ahead = -1;
+  return c;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  written++;
+  if (echo) {
+    fputc(c, stderr);
+  }
+  if (fd < 0) {
+    return 1;
+  }
+  if (noisyAbove > 0 && rate > noisyAbove && rand() % 8 == 0) {
+    c ^= 1 << (rand() % 8);
+    garbled++;
+  }
+  uint8_t pair[2] = {(uint8_t) (rate / 2400), c};
+  size_t sent = 0;
+  while (sent < 2) {
+    ssize_t n = ::write(fd, pair + sent, 2 - sent);
+    if (n > 0) {
+      sent += n;
+    }
+    else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+      break;
+    }
+  }
+  return 1;
+}
+
+File::File(FILE *file) {
+  this->file = file;
+}
+
+int File::read() {
+  return file ? fgetc(file) : -1;
+}
+
+int File::peek() {
+  int c = read();
+  if (c >= 0) {
+    ungetc(c, file);
+  }
+  return c;
+}
+
+int File::available() {
+  return peek() >= 0 ? 1 : 0;
+}
+
+uint32_t File::position() {
+  return ftell(file);
+}
+
+bool File::seek(uint32_t position) {
+  return fseek(file, position, SEEK_SET) == 0;
+}
+
+void File::close() {
+  if (file) {
+    fclose(file);
+  }
+  file = NULL;
+}
+
+bool SDClass::begin(uint8_t csPin) {
+  return true;
+}
+
+File SDClass::open(const char *name, uint8_t mode) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", root, name);
+  return File(fopen(path, "r"));
+}
@@ -0,0 +1,323 @@
+/*
+  Sends the same syncs with the text protocol the sketch used before
+  the binary frames (copied below from the old comm.h) and with the
+  frames in comm.h, then prints the bytes each puts on the wire and how
+  long the receiving board takes to decode the board. A sync is the
+  handshake, the board and the answer to it.
+
+  The text protocol always sent every territory and the frames only
+  send the ones that changed, so each map gets two rows: every
+  territory changed (the first sync, or after SNAPSHOT_REQUEST), and
+  TURN_CHANGES of them, about what one turn changes. The boards
+  alternate between two states so every decode changes territories.
+
+  Host timings only compare with each other. They leave out the AVR's
+  heap cost of the text protocol's Strings, and its Serial.println of
+  every field, which on the board took longer than the rest.
+
+  Usage: link_bench mapdir...
+*/
+
+#include "readFile.h"
+#include "comm.h"
+#include <time.h>
+#include <vector>
+
+// the territories a turn changes
+#define TURN_CHANGES 5
+// how many syncs each decoder is timed over
+#define SYNCS 2000
+
+territory *territories;
+
+static double seconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// keeps what the text protocol writes
+class ByteSink : public Print {
+public:
+  size_t write(uint8_t data) {
+    bytes.push_back(data);
+    return 1;
+  }
+  using Print::write;
+
+  std::vector<uint8_t> bytes;
+};
+
+// a serial port that keeps what LinkSender gives it
+class WireTap : public HardwareSerial {
+public:
+  size_t write(uint8_t data) {
+    bytes.push_back(data);
+    return HardwareSerial::write(data);
+  }
+  using Print::write;
+
+  std::vector<uint8_t> bytes;
+};
+
+// plays bytes back to the text protocol's reader
+class ByteSource : public Stream {
+public:
+  ByteSource(const std::vector<uint8_t> &data) : bytes(data) {
+    at = 0;
+  }
+  int available() {
+    return bytes.size() - at;
+  }
+  int peek() {
+    return at < bytes.size() ? bytes[at] : -1;
+  }
+  int read() {
+    int c = peek();
+    at += c >= 0;
+    return c;
+  }
+  void flush() {
+  }
+  size_t write(uint8_t) {
+    return 0;
+  }
+  using Print::write;
+
+private:
+  const std::vector<uint8_t> &bytes;
+  size_t at;
+};
+
+// The text protocol, as comm.h had it before the frames, with port in
+// place of Serial3 and without the Serial3.flush() after each record
+
+//read one 'word' at a time
+String timedRead(Stream &port, const int patience) {
+  String input;
+  char current;
+  uint32_t startTime = millis();
+
+  while (true) {
+    if (port.available() != 0) {
+      current = port.read();
+      //if there is a separating character, return the string
+      //therefore splitting characters automatically
+      if (current != '\n' and current != ' ') {
+        input += current;
+      }
+      else {
+        return input;
+      }
+    }
+    else if ((millis() - startTime) > patience) {
+      return "";
+    }
+  }
+}
+//send points
+void textSendPoints(Print &port, territory*& allTerr, int length)
+{
+    port.println();
+    port.print("B ");
+    for (int i = 0; i < length; ++i)
+    {
+        port.print("T ");
+        port.print(allTerr[i].id);
+        port.print(' ');
+        port.print(allTerr[i].power);
+        port.print(' ');
+        port.print(allTerr[i].team);
+        port.print(' ');
+    }
+}
+//recieve points
+bool textRecievePoints(Stream &port, masterMapGraph*& gameMap, territory*& allTerr, int length)
+{
+    //the current token recieved
+    String item;
+
+    int parameters[3];
+
+    while(!port.available()) {}
+
+    item = timedRead(port, 1000);
+    //starting character
+    if (strcmp(item.c_str(), "B") != 0)
+    {
+        Serial.println("Out of sync");
+        return false;
+    }
+    for (int i = 0; i < length; ++i)
+    {
+        while(!port.available()) {}
+
+        item = timedRead(port, 1000);
+
+        if (strcmp(item.c_str(), "T") != 0)
+        {
+            return false;
+        }
+
+        for (int j = 0; j < 3; ++j)
+        {
+            while(!port.available()) {}
+            item = timedRead(port, 1000);
+
+            parameters[j] = item.toInt();
+            Serial.println(item);
+        }
+        //changes a map node if it is different from what was recieved
+        if (allTerr[i].power != parameters[1])
+        {
+            allTerr[i].power = parameters[1];
+        }
+        if (allTerr[i].team != parameters[2])
+        {
+            allTerr[i].team = parameters[2];
+            gameMap->flip(allTerr[i]);
+        }
+    }
+    return true;
+}
+
+// decodes a board the way recievePoints() does, without answering it
+static bool frameRecievePoints(LinkReceiver &link, const std::vector<uint8_t> &bytes, masterMapGraph *&map, int count) {
+  int records = 0;
+  bool complete = false;
+  linkEvent event;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    link.feed(bytes[i]);
+    while (link.next(event)) {
+      if (event.type == FRAME_TERRITORIES) {
+        for (int k = 0; k + TERRITORY_RECORD_SIZE <= event.length; k += TERRITORY_RECORD_SIZE) {
+          records += applyTerritory(map, territories, count, event.payload + k);
+        }
+      }
+      else if (event.type == FRAME_BOARD_END) {
+        complete = event.length == 1 && event.payload[0] == (uint8_t) records;
+      }
+    }
+  }
+  return complete;
+}
+
+// the bytes of one sync of board with changes, and how long decoding
+// the boards takes (us), returns how many decodes failed
+static int bench(masterMapGraph *&map, int count, const std::vector<territory> *boards,
+                 const changeSet &changes, int *textBytes, int *frameBytes, double *textTime, double *frameTime) {
+  int wrong = 0;
+
+  // the text protocol: 'A', "R\r\n", the board, then the same again
+  ByteSink text[2];
+  for (int b = 0; b < 2; ++b) {
+    territory *board = const_cast<territory *>(&boards[b][0]);
+    textSendPoints(text[b], board, count);
+  }
+  ByteSink answers;
+  answers.print('A');
+  answers.println('R');
+  *textBytes = text[1].bytes.size() + 2 * answers.bytes.size();
+
+  // the frames: FRAME_HELLO, FRAME_READY, the board, BOARD_ACK
+  WireTap tap[2];
+  for (int b = 0; b < 2; ++b) {
+    LinkSender out(tap[b]);
+    out.setRate(LINK_RATE_COUNT - 1);
+    territory *board = const_cast<territory *>(&boards[b][0]);
+    sendPoints(board, count, changes, out);
+    while (out.pending() > 0) {
+      out.pump();
+    }
+  }
+  WireTap controls;
+  LinkSender out(controls);
+  sendControl(out, FRAME_HELLO);
+  sendControl(out, FRAME_READY);
+  sendControl(out, BOARD_ACK);
+  while (out.pending() > 0) {
+    out.pump();
+  }
+  *frameBytes = tap[1].bytes.size() + controls.bytes.size();
+
+  // the receiver starts at boards[0] and gets boards[1], boards[0], ...
+  double start = seconds();
+  for (int s = 0; s < SYNCS; ++s) {
+    ByteSource port(text[(s + 1) % 2].bytes);
+    // the "\r" the leading println leaves fails the first try
+    bool taken = false;
+    for (int tries = 0; !taken && tries < 2; ++tries) {
+      taken = textRecievePoints(port, map, territories, count);
+    }
+    wrong += !taken;
+  }
+  *textTime = (seconds() - start) * 1e6 / SYNCS;
+  for (int i = 0; i < count; ++i) {
+    wrong += territories[i].team != boards[0][i].team || territories[i].power != boards[0][i].power;
+  }
+
+  LinkReceiver link;
+  start = seconds();
+  for (int s = 0; s < SYNCS; ++s) {
+    wrong += !frameRecievePoints(link, tap[(s + 1) % 2].bytes, map, count);
+  }
+  *frameTime = (seconds() - start) * 1e6 / SYNCS;
+  for (int i = 0; i < count; ++i) {
+    wrong += territories[i].team != boards[0][i].team || territories[i].power != boards[0][i].power;
+  }
+  return wrong;
+}
+
+static void row(int count, int changed, int textBytes, int frameBytes, double textTime, double frameTime) {
+  printf("%11d  %7d  %5d (%4.0f ms)  %5d (%4.0f ms)  %8.1f us  %8.1f us\n", count, changed,
+         textBytes, textBytes * 10000.0 / 9600, frameBytes, frameBytes * 10000.0 / 9600, textTime, frameTime);
+}
+
+int main(int argc, char **argv) {
+  int wrong = 0;
+  printf("bytes per sync (at 9600 baud), and decode time per board\n");
+  printf("territories  changed       text              frames         text       frames\n");
+  for (int m = 1; m < argc; ++m) {
+    SD.root = argv[m];
+    masterMapGraph *map = makeMap(territories);
+    int count = map->size();
+    srand(1);
+
+    // every territory changed: a new power, and every third one a new team
+    std::vector<territory> boards[2];
+    boards[0].assign(territories, territories + count);
+    boards[1] = boards[0];
+    for (int i = 0; i < count; ++i) {
+      boards[1][i].power += 1 + rand() % 5;
+      if (i % 3 == 0) {
+        boards[1][i].team = 3 - boards[1][i].team;
+      }
+    }
+    changeSet changes;
+    changes.begin(count);
+    changes.markAll();
+    int textBytes, frameBytes;
+    double textTime, frameTime;
+    wrong += bench(map, count, boards, changes, &textBytes, &frameBytes, &textTime, &frameTime);
+    row(count, count, textBytes, frameBytes, textTime, frameTime);
+
+    // a turn: TURN_CHANGES territories spread over the map changed
+    boards[1] = boards[0];
+    changes.begin(count);
+    for (int k = 0; k < TURN_CHANGES; ++k) {
+      int id = k * count / TURN_CHANGES;
+      boards[1][id].power += 1 + rand() % 5;
+      boards[1][id].team = 3 - boards[1][id].team;
+      changes.mark(id);
+    }
+    wrong += bench(map, count, boards, changes, &textBytes, &frameBytes, &textTime, &frameTime);
+    row(count, TURN_CHANGES, textBytes, frameBytes, textTime, frameTime);
+
+    delete map;
+    delete[] territories;
+  }
+  if (wrong > 0) {
+    printf("%d boards didn't decode to what was sent\n", wrong);
+  }
+  return wrong > 0;
+}
@@ -0,0 +1,206 @@
+/*
+  Runs player 1 and player 2 in two processes joined by a
+  pseudo-terminal, the way the boards are joined by Serial3. Player 1
+  negotiates the rate in setup() and sends boards until player 2 has
+  taken BOARDS of them, then both have to hold the same territories.
+
+  Each player runs its own sketch: this file is built from riskGameP1's
+  risk.cpp as link_pty_test and from riskGameP2's, with PTY_PLAYER2, as
+  link_pty_player2, which link_pty_test starts for the other end. So
+  player 2 sits on its welcome screen first, like the real board.
+
+  Three links: a clean one, one where the host serial port garbles
+  bytes sent above 38400 baud so the rate has to come down, and one
+  with nothing on the other end, where setup() has to give up and stay
+  at the base rate instead of waiting forever.
+
+  Only the first map is used, the link doesn't care how big it is.
+
+  Usage: link_pty_test mapdir... (link_pty_player2 has to be next to it)
+*/
+
+#define main sketch_main
+#include "risk.cpp"
+#undef main
+
+#include <fcntl.h>
+#include <pty.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BOARDS 10
+// a test that takes longer than this is hung (s)
+#define PTY_TIMEOUT 60
+
+// the territories, folded into one number to compare the boards with
+static uint32_t boardSum() {
+  uint32_t sum = 0;
+  for (int i = 0; i < NUM_TERR; ++i) {
+    sum = sum * 31 + territories[i].power * 3 + territories[i].team;
+  }
+  return sum;
+}
+
+#ifdef PTY_PLAYER2
+
+// player 2, takes the boards and writes what it ended up with to result
+// Usage: link_pty_player2 fd result noisyAbove mapdir
+int main(int argc, char **argv) {
+  if (argc != 5) {
+    return 1;
+  }
+  int fd = atoi(argv[1]);
+  int result = atoi(argv[2]);
+  SD.root = argv[4];
+  alarm(PTY_TIMEOUT);
+  Serial3.attach(fd);
+  Serial3.noisyAbove = strtoul(argv[3], NULL, 10);
+  srand(2);
+  masterMapGraph *map;
+  touchGrid grid;
+  setup(map, grid, 2);
+  for (int b = 0; b < BOARDS; ++b) {
+    while (!recievePoints(map, territories, NUM_TERR, incoming, outgoing)) {
+    }
+  }
+  // lets the last answer go out
+  for (int k = 0; k < 200; ++k) {
+    outgoing.pump();
+    usleep(1000);
+  }
+  uint32_t sum = boardSum();
+  write(result, &sum, sizeof(sum));
+  return 0;
+}
+
+#else
+
+static double seconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void raw(int fd) {
+  struct termios t;
+  tcgetattr(fd, &t);
+  cfmakeraw(&t);
+  tcsetattr(fd, TCSANOW, &t);
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+}
+
+// link_pty_player2, next to this program
+static char player2[4096];
+
+// starts player 2 on fd, it writes what it ended up with to result
+static void startPlayer2(int fd, int result, unsigned long noisyAbove) {
+  char fdArg[16], resultArg[16], noisyArg[16];
+  snprintf(fdArg, sizeof(fdArg), "%d", fd);
+  snprintf(resultArg, sizeof(resultArg), "%d", result);
+  snprintf(noisyArg, sizeof(noisyArg), "%lu", noisyAbove);
+  execl(player2, player2, fdArg, resultArg, noisyArg, SD.root, (char *) NULL);
+  perror(player2);
+  _exit(1);
+}
+
+// player 1, returns how many things went wrong
+static int runLink(const char *what, unsigned long noisyAbove, bool answered) {
+  int master, slave, result[2];
+  if (openpty(&master, &slave, NULL, NULL, NULL) < 0 || pipe(result) < 0) {
+    perror("openpty");
+    return 1;
+  }
+  raw(master);
+  raw(slave);
+  fflush(stdout);
+  pid_t child = answered ? fork() : -1;
+  if (child == 0) {
+    close(master);
+    startPlayer2(slave, result[1], noisyAbove);
+  }
+
+  pid_t self = fork();
+  if (self != 0) {
+    // the sketch keeps its state in globals, so player 1 runs in a
+    // process of its own too
+    int status;
+    waitpid(self, &status, 0);
+    if (child > 0) {
+      kill(child, SIGKILL);
+      waitpid(child, NULL, 0);
+    }
+    close(master);
+    close(slave);
+    close(result[0]);
+    close(result[1]);
+    return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  }
+
+  alarm(PTY_TIMEOUT);
+  Serial3.attach(master);
+  Serial3.noisyAbove = noisyAbove;
+  srand(1);
+  masterMapGraph *map;
+  touchGrid grid;
+  double start = seconds();
+  setup(map, grid, 1);
+  double negotiated = seconds() - start;
+  printf("%s: setup() took %.1f s and picked %lu baud", what, negotiated, (unsigned long) outgoing.baud());
+
+  int wrong = 0;
+  if (!answered) {
+    printf("\n");
+    fflush(stdout);
+    wrong += outgoing.rate() != 0;
+    _exit(wrong);
+  }
+  // the fastest rate that isn't noisy has to be agreed on
+  if (noisyAbove > 0) {
+    wrong += outgoing.baud() != noisyAbove;
+  }
+  else {
+    wrong += outgoing.rate() != LINK_RATE_COUNT - 1;
+  }
+
+  for (int b = 0; b < BOARDS; ++b) {
+    for (int k = 0; k < 5; ++k) {
+      int id = rand() % NUM_TERR;
+      territories[id].power += 1 + rand() % 5;
+      markDirty(id);
+    }
+    while (!handshake(incoming, outgoing)) {
+    }
+    bool taken;
+    do {
+      sendBoard(territories, NUM_TERR, unsynced, incoming, outgoing);
+      taken = boardTaken(unsynced, incoming, outgoing);
+    } while (!taken);
+  }
+  uint32_t theirs = 0;
+  wrong += read(result[0], &theirs, sizeof(theirs)) != sizeof(theirs);
+  wrong += theirs != boardSum();
+  printf(", %d boards %s, ended at %lu baud, %u retries, %u bad frames\n",
+         BOARDS, theirs == boardSum() ? "matched" : "differed",
+         (unsigned long) outgoing.baud(), outgoing.retries(), incoming.badFrames());
+  fflush(stdout);
+  _exit(wrong);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    return 1;
+  }
+  SD.root = argv[1];
+  const char *slash = strrchr(argv[0], '/');
+  int dir = slash ? slash - argv[0] + 1 : 0;
+  snprintf(player2, sizeof(player2), "%.*slink_pty_player2", dir, argv[0]);
+  int failed = 0;
+  failed += runLink("clean", 0, true);
+  failed += runLink("noisy above 38400", 38400, true);
+  failed += runLink("nobody there", 0, false);
+  return failed > 0;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+  Feeds LinkReceiver frames that were garbled on the way, and checks
+  that nothing but whole frames with a good CRC comes out. In
+  particular, what is left of a dropped frame must never be taken for
+  a control message, e.g. a payload byte that happens to be BOARD_ACK.
+
+  Usage: link_test
+*/
+
+#include "comm.h"
+#include <vector>
+
+territory *territories;
+
+// keeps what a FrameEncoder writes
+class ByteSink : public Print {
+public:
+  size_t write(uint8_t data) {
+    bytes.push_back(data);
+    return 1;
+  }
+  using Print::write;
+
+  std::vector<uint8_t> bytes;
+};
+
+static std::vector<uint8_t> frameBytes(uint8_t type, const uint8_t *payload, uint8_t length) {
+  ByteSink sink;
+  FrameEncoder frame(sink);
+  frame.begin(type, length);
+  for (uint8_t i = 0; i < length; ++i) {
+    frame.put(payload[i]);
+  }
+  frame.end();
+  return sink.bytes;
+}
+
+// feeds the bytes and counts the messages that come out
+static int events(LinkReceiver &link, const std::vector<uint8_t> &bytes, linkEvent *last = NULL) {
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    link.feed(bytes[i]);
+  }
+  int found = 0;
+  linkEvent event;
+  while (link.next(event)) {
+    found++;
+    if (last != NULL) {
+      *last = event;
+    }
+  }
+  return found;
+}
+
+int main() {
+  int wrong = 0;
+  int cases = 0;
+
+  // a payload full of the control types
+  uint8_t payload[FRAME_MAX_PAYLOAD];
+  const uint8_t controls[] = {FRAME_HELLO, FRAME_READY, BOARD_ACK, SNAPSHOT_REQUEST};
+  for (int i = 0; i < FRAME_MAX_PAYLOAD; ++i) {
+    payload[i] = controls[i % 4];
+  }
+  std::vector<uint8_t> board = frameBytes(FRAME_TERRITORIES, payload, FRAME_MAX_PAYLOAD);
+
+  // every control frame comes through on its own
+  for (int c = 0; c < 4; ++c) {
+    LinkReceiver link;
+    linkEvent event;
+    wrong += events(link, frameBytes(controls[c], NULL, 0), &event) != 1
+        || event.type != controls[c] || event.length != 0;
+    cases++;
+  }
+
+  // the board frame whole, then with its sync byte, length or one payload
+  // byte garbled, then cut short and followed by a good frame
+  for (int garble = -1; garble < (int) board.size(); ++garble) {
+    LinkReceiver link;
+    std::vector<uint8_t> bytes = board;
+    if (garble >= 0) {
+      bytes[garble] ^= (garble == 2) ? 0x80 : 0x01;
+    }
+    int found = events(link, bytes);
+    wrong += found != (garble < 0 ? 1 : 0);
+    cases++;
+  }
+  for (size_t cut = 1; cut < board.size(); ++cut) {
+    LinkReceiver link;
+    std::vector<uint8_t> bytes(board.begin() + cut, board.end());
+    std::vector<uint8_t> ack = frameBytes(BOARD_ACK, NULL, 0);
+    bytes.insert(bytes.end(), ack.begin(), ack.end());
+    linkEvent event;
+    // only the answer, nothing from the rest of the board, though the
+    // decoder may swallow it if a payload byte looked like a frame start
+    int found = events(link, bytes, &event);
+    wrong += found > 1 || (found == 1 && event.type != BOARD_ACK);
+    cases++;
+  }
+
+  // control characters on their own, the way they used to be sent
+  {
+    LinkReceiver link;
+    std::vector<uint8_t> bytes(controls, controls + 4);
+    wrong += events(link, bytes) != 0 || link.droppedBytes() != 4;
+    cases++;
+  }
+
+  printf("%d garbled streams, %d wrong\n", cases, wrong);
+  return wrong > 0;
+}
@@ -0,0 +1,56 @@
+/*
+  Loads a map with makeMap() and prints everything the sketch reads
+  from it: each territory's position, continent, type, owner and
+  armies, its roads (sorted) and what isNeighbour() says about every
+  other territory, then each team's territories and continent bonus.
+
+  'make test' builds it twice: reading map.txt from the SD card, and
+  with MAP_IN_FLASH and the mapData.h that mapdata writes for the same
+  map. Both have to print the same thing.
+
+  Usage: map_dump mapdir (the MAP_IN_FLASH build ignores it)
+*/
+
+#include "readFile.h"
+#include <vector>
+#include <algorithm>
+
+territory *territories;
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: map_dump mapdir\n");
+    return 1;
+  }
+  SD.root = argv[1];
+  masterMapGraph *map = makeMap(territories);
+  int count = map->size();
+
+  printf("%d territories\n", count);
+  for (int t = 0; t < count; ++t) {
+    printf("T %d: at %d,%d, continent %d, type %d, magnitude %d, team %d, power %d, roads to",
+           t, terrX(t), terrY(t), terrCont(t), terrType(t), terrMagnitude(t),
+           territories[t].team, territories[t].power);
+    std::vector<int> roads;
+    for (masterMapGraph::NeighbourIterator i = map->neighbours(t); !map->isLastNeighbour(t, i); i = map->nextNeighbour(t, i)) {
+      roads.push_back(i.item().val);
+    }
+    std::sort(roads.begin(), roads.end());
+    for (size_t k = 0; k < roads.size(); ++k) {
+      printf(" %d", roads[k]);
+    }
+    printf(" (%d)\n  isNeighbour:", map->numNeighbours(t));
+    for (int u = 0; u < count; ++u) {
+      if (map->isNeighbour(t, u)) {
+        printf(" %d", u);
+      }
+    }
+    printf("\n");
+  }
+  for (int team = 1; team <= 2; ++team) {
+    printf("team %d: %d territories, continent bonus %d\n", team, map->territoriesOwned(team), map->continentBonus(team));
+  }
+  delete map;
+  delete[] territories;
+  return 0;
+}
@@ -0,0 +1,152 @@
+/*
+  Writes the mapData.h that MAP_IN_FLASH compiles in, from a map.txt:
+  the T lines become MAP_INFO and the P lines become the MAP_OFFSETS and
+  MAP_ROADS rows, each road listed under both of its territories once
+  (a road the file lists twice is only kept once, like the SD reader).
+
+  Usage: mapdata map.txt > mapData.h
+  'make mapdata MAP=path/to/map.txt' writes both sketches' mapData.h.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <set>
+#include <string>
+#include <algorithm>
+
+struct terrLine {
+  int x, y, team, cont, type, magnitude, power;
+};
+
+static bool fits(int value, int most) {
+  return value >= 0 && value <= most;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: mapdata map.txt > mapData.h\n");
+    return 1;
+  }
+  FILE *file = fopen(argv[1], "r");
+  if (file == NULL) {
+    fprintf(stderr, "mapdata: can't open %s\n", argv[1]);
+    return 1;
+  }
+
+  int count, edges, conts;
+  if (fscanf(file, "B %d %d %d\n", &count, &edges, &conts) != 3 || !fits(count, 255) || !fits(conts, 255)) {
+    fprintf(stderr, "mapdata: %s doesn't start with a B line the sketch can load\n", argv[1]);
+    return 1;
+  }
+  std::vector<terrLine> info(count);
+  std::vector<std::set<int> > roads(count);
+  for (int i = 0; i < count; ++i) {
+    terrLine t;
+    int id;
+    if (fscanf(file, "T %d %d %d %d %d %d %d %d\n", &t.x, &t.y, &id, &t.team, &t.cont, &t.type, &t.magnitude, &t.power) != 8
+        || !fits(id, count - 1) || !fits(t.x, 65535) || !fits(t.y, 65535) || !fits(t.team, 255) || !fits(t.cont, conts - 1)
+        || !fits(t.type, 255) || !fits(t.magnitude, 255) || !fits(t.power, 255)) {
+      fprintf(stderr, "mapdata: T line %d is wrong or doesn't fit in MAP_INFO\n", i);
+      return 1;
+    }
+    info[id] = t;
+  }
+  for (int i = 0; i < edges; ++i) {
+    int from, to;
+    if (fscanf(file, "P %d %d\n", &from, &to) != 2 || !fits(from, count - 1) || !fits(to, count - 1)) {
+      fprintf(stderr, "mapdata: P line %d is wrong\n", i);
+      return 1;
+    }
+    roads[from].insert(to);
+    roads[to].insert(from);
+  }
+  fclose(file);
+
+  int listed = 0;
+  for (int t = 0; t < count; ++t) {
+    listed += roads[t].size();
+  }
+
+  printf("#ifndef _MAP_DATA_H\n"
+         "#define _MAP_DATA_H\n"
+         "\n"
+         "#include <Arduino.h>\n"
+         "#include <avr/pgmspace.h>\n"
+         "\n"
+         "/*\n"
+         "  A map compiled into flash, used instead of map.txt when MAP_IN_FLASH\n"
+         "  is defined. Nothing here is copied into RAM except each territory's\n"
+         "  starting team and power.\n"
+         "\n"
+         "  The tables hold the same information as map.txt:\n"
+         "    MAP_INFO    - one record per T line, indexed by territory id\n"
+         "    MAP_OFFSETS - territory t's roads are MAP_ROADS[MAP_OFFSETS[t]] up to\n"
+         "                  MAP_ROADS[MAP_OFFSETS[t+1] - 1]\n"
+         "    MAP_ROADS   - every P line listed under both of its territories\n"
+         "\n"
+         "  Written by test/mapdata.cpp, don't edit it by hand. To compile in a\n"
+         "  different map, run 'make mapdata MAP=path/to/map.txt' in test/.\n"
+         "*/\n"
+         "\n"
+         "#define MAP_TERRITORIES %d\n"
+         "#define MAP_CONTINENTS %d\n"
+         "#define MAP_NUM_ROADS %d\n"
+         "\n"
+         "// one T line of map.txt (the id is the index in MAP_INFO)\n"
+         "struct terrInfo\n"
+         "{\n"
+         "    uint16_t x;\n"
+         "    uint16_t y;\n"
+         "    //starting owner\n"
+         "    uint8_t team;\n"
+         "    uint8_t cont;\n"
+         "    uint8_t type;\n"
+         "    uint8_t magnitude;\n"
+         "    //starting armies\n"
+         "    uint8_t power;\n"
+         "};\n"
+         "\n"
+         "const terrInfo MAP_INFO[MAP_TERRITORIES] PROGMEM = {\n"
+         "    // x,   y, team, cont, type, magnitude, power\n",
+         count, conts, listed / 2);
+  for (int t = 0; t < count; ++t) {
+    printf("    {%3d, %3d, %d, %d, %d, %d, %d}, // %d\n", info[t].x, info[t].y, info[t].team,
+           info[t].cont, info[t].type, info[t].magnitude, info[t].power, t);
+  }
+  printf("};\n"
+         "\n"
+         "const uint16_t MAP_OFFSETS[MAP_TERRITORIES + 1] PROGMEM = {\n"
+         "   ");
+  int offset = 0;
+  for (int t = 0; t <= count; ++t) {
+    printf(" %d%s", offset, t < count ? "," : "");
+    if (t % 17 == 16 && t < count) {
+      printf("\n   ");
+    }
+    if (t < count) {
+      offset += roads[t].size();
+    }
+  }
+  printf("\n};\n"
+         "\n"
+         "const uint8_t MAP_ROADS[2 * MAP_NUM_ROADS] PROGMEM = {\n");
+  // the rows, with their comments lined up
+  std::vector<std::string> rows(count);
+  size_t widest = 0;
+  for (int t = 0; t < count; ++t) {
+    for (std::set<int>::iterator i = roads[t].begin(); i != roads[t].end(); ++i) {
+      char road[8];
+      snprintf(road, sizeof(road), "%d, ", *i);
+      rows[t] += road;
+    }
+    widest = std::max(widest, rows[t].size());
+  }
+  for (int t = 0; t < count; ++t) {
+    printf("    %-*s// %d\n", (int) widest, rows[t].c_str(), t);
+  }
+  printf("};\n"
+         "\n"
+         "#endif\n");
+  return 0;
+}
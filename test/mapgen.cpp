@@ -0,0 +1,76 @@
+/*
+  Writes a map.txt for the tests: territories on a grid, each joined to
+  its neighbours to the right and below, teams alternating.
+
+  Usage: mapgen territories [seed] [repeats] [unowned] > map.txt
+  repeats is how many of the roads are listed a second time, the reader
+  has to cope with that. With unowned, every unowned'th territory gets
+  team 0 (no owner).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+// the same numbers on every PC
+static unsigned long state;
+
+static int next(int below) {
+  state = state * 1103515245UL + 12345UL;
+  return (state >> 16) % below;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: mapgen territories [seed] [repeats] [unowned]\n");
+    return 1;
+  }
+  int n = atoi(argv[1]);
+  state = argc > 2 ? atoi(argv[2]) : 1;
+  int repeats = argc > 3 ? atoi(argv[3]) : 0;
+  int unowned = argc > 4 ? atoi(argv[4]) : 0;
+  int columns = (int) sqrt(2.0 * n);
+  if (columns < 1) {
+    columns = 1;
+  }
+  const int continents = 4;
+  // special tile types, most territories are plain
+  const int types[] = {0, 0, 0, 1, 2, 3, 4};
+
+  std::vector<std::pair<int, int> > roads;
+  for (int i = 0; i < n; ++i) {
+    int across[] = {i + 1, i + columns, i + columns + 1, i + 2};
+    for (int k = 0; k < 4; ++k) {
+      if (across[k] < n) {
+        roads.push_back(std::make_pair(i, across[k]));
+      }
+    }
+  }
+  std::sort(roads.begin(), roads.end());
+  roads.erase(std::unique(roads.begin(), roads.end()), roads.end());
+  int unique = roads.size();
+  for (int k = 0; k < repeats && unique > 0; ++k) {
+    std::pair<int, int> road = roads[next(unique)];
+    // either way round
+    if (k % 2) {
+      std::swap(road.first, road.second);
+    }
+    roads.push_back(road);
+  }
+
+  printf("B %d %d %d\n", n, (int) roads.size(), continents);
+  for (int i = 0; i < n; ++i) {
+    int x = 10 + (i % columns) * 45;
+    int y = 10 + (i / columns) * 45;
+    int team = (unowned > 0 && i % unowned == 0) ? 0 : 1 + i % 2;
+    printf("T %d %d %d %d %d %d %d %d\n", x, y, i, team, i % continents,
+           types[next(7)], 1 + next(3), 1 + next(5));
+  }
+  for (size_t k = 0; k < roads.size(); ++k) {
+    printf("P %d %d\n", roads[k].first, roads[k].second);
+  }
+  return 0;
+}
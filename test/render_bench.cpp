@@ -0,0 +1,77 @@
+/*
+  What the sketch's screens send to the display: drawAll, a page switch,
+  a joystick step and an attack, with tftStats.h counting. At the
+  shield's 8 MHz SPI clock a byte takes 1 us, so the SPI bytes are
+  roughly the microseconds the board spends drawing.
+
+  Built with TFT_STATS. Each map runs in its own process, like
+  render_test.
+
+  Usage: render_bench mapdir...
+*/
+
+#define main sketch_main
+#include "risk.cpp"
+#undef main
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// the counts of the last frame the sketch drew
+static void report(const char *what) {
+  printf("  %-12s %5u calls %7lu pixels %6lu windows %8lu SPI bytes\n",
+         what, tft.drawCalls(), tft.pixelsDrawn(), tft.windowsSet(), tft.spiBytes());
+}
+
+static void bench(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map;
+  touchGrid grid;
+  setup(map, grid, 2);
+  printf("%s: %d territories, %dx%d map\n", dir, NUM_TERR, mapWidth, mapHeight);
+
+  drawAll(map, 1);
+  report("drawAll");
+  nextPageTouch(map, 1);
+  report("page switch");
+  // back to the start, so the camera has room to move
+  cameraX = cameraY = 0;
+  drawMapArea(map);
+  panCamera(map, JOY_PAN_SPEED, JOY_PAN_SPEED);
+  if (cameraX != 0 || cameraY != 0) {
+    report("pan");
+  }
+
+  // an attack that can't end the game, from a territory with an enemy
+  // next to it on screen
+  for (int from = 0; from < NUM_TERR; ++from) {
+    int to = -1;
+    for (int n = 0; n < NUM_TERR; ++n) {
+      if (map->isNeighbour(from, n) && territories[n].team == 3 - territories[from].team) {
+        to = n;
+      }
+    }
+    if (to < 0 || !currentView().contains(terrX(to), terrY(to)) || map->territoriesOwned(3 - territories[from].team) < 2) {
+      continue;
+    }
+    territories[from].power = 20;
+    territories[to].power = 5;
+    attack(territories[from].team, from, to, map);
+    report("attack");
+    break;
+  }
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+      bench(argv[i]);
+      exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+  }
+  return 0;
+}
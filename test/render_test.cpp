@@ -0,0 +1,183 @@
+/*
+  Draws the sketch's screens into the host display and checks that the
+  shortcuts it takes leave the same picture as drawing everything again:
+  redrawing only the territories that changed, and panning the camera.
+  Also checks tftStats.h's counts against what the display got, and
+  saves the screens as PPM images next to the map.
+
+  Built with TFT_STATS, and as render_list with DISPLAY_LIST too, where
+  it also checks the side bar always fit in the display list. Each map
+  runs in its own process, the sketch keeps its state in globals that
+  only setup() starts.
+
+  Usage: render_test mapdir...
+*/
+
+#define main sketch_main
+#include "risk.cpp"
+#undef main
+
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static uint16_t reference[TFT_HEIGHT][TFT_WIDTH];
+
+static void keep() {
+  for (int y = 0; y < TFT_HEIGHT; ++y) {
+    for (int x = 0; x < TFT_WIDTH; ++x) {
+      reference[y][x] = tft.pixel(x, y);
+    }
+  }
+}
+
+// the pixels that differ from what keep() saved
+static long differences() {
+  long wrong = 0;
+  for (int y = 0; y < TFT_HEIGHT; ++y) {
+    for (int x = 0; x < TFT_WIDTH; ++x) {
+      wrong += tft.pixel(x, y) != reference[y][x];
+    }
+  }
+  return wrong;
+}
+
+// what the screen should show, drawn from scratch
+static void redrawAll(masterMapGraph *&map, int player) {
+  drawMapArea(map);
+  sideBar(player);
+}
+
+static void save(const char *dir, const char *name) {
+  std::string path = std::string(dir) + "/" + name + ".ppm";
+  if (!tft.savePPM(path.c_str())) {
+    printf("%s: can't write %s\n", dir, path.c_str());
+  }
+}
+
+static int check(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map;
+  touchGrid grid;
+  // player 2 doesn't wait for the other board in setup()
+  setup(map, grid, 2);
+  save(dir, "setup");
+
+  // the host's analog pins read centred, a floating one turns the
+  // joystick off. Each check samples each axis once, the core's abs()
+  // is a macro that would read the pin twice
+  long wrongJoystick = !joystickFound;
+  unsigned long reads = hostAnalogReads;
+  joystickCentred();
+  wrongJoystick += hostAnalogReads - reads != 2 * JOY_CHECKS;
+  hostPinValue[JOY_VERT_ANALOG] = 700;
+  wrongJoystick += joystickCentred();
+  hostPinValue[JOY_VERT_ANALOG] = JOY_CENTRE;
+
+  // the counts are exact for the map area, the armies are drawn with
+  // the digit font's rectangles
+  long wrongCounts = 0;
+  tft.resetCounts();
+  tft.resetBus();
+  drawMapArea(map);
+  wrongCounts += tft.pixelsDrawn() != tft.busPixels;
+  wrongCounts += tft.windowsSet() != tft.busWindows;
+  wrongCounts += tft.spiBytes() != tft.busBytes();
+  // and an upper bound for text, which they count as whole character cells
+  tft.resetCounts();
+  tft.resetBus();
+  tft.setCursor(0, 0);
+  tft.setTextSize(2);
+  tft.print("Risk 123");
+  wrongCounts += tft.pixelsDrawn() < tft.busPixels;
+  wrongCounts += tft.windowsSet() < tft.busWindows;
+  drawMapArea(map);
+
+  // the armies left counting down the way distribute() shows them, the
+  // first number draws the whole side bar
+  long wrongArmies = 0;
+  unsigned long armiesBytes = 0;
+  armiesLeft = -1;
+  sideBar(1);
+  for (int armies = 12; armies >= 0; --armies) {
+    tft.resetBus();
+    updateArmiesLeft(1, armies);
+    armiesBytes = max(armiesBytes, tft.busBytes());
+    keep();
+    sideBar(1);
+    wrongArmies += differences();
+  }
+  tft.resetBus();
+  updateArmiesLeft(1, 3);
+  unsigned long armiesUpdate = tft.busBytes();
+  // back to the side bar setup() drew
+  armiesLeft = -1;
+  sideBar(2);
+
+  // changed territories, redrawn on their own
+  srand(1);
+  long wrongRedraw = 0;
+  for (int k = 0; k < 50; ++k) {
+    for (int c = 0; c < 3; ++c) {
+      int id = rand() % NUM_TERR;
+      // mostly counts the digit font covers, and some bigger or
+      // negative ones that are drawn small
+      territories[id].power = (rand() % 4 == 0) ? rand() % 40000 - 20000 : rand() % 100;
+      territories[id].team = 1 + rand() % 2;
+      map->flip(territories[id]);
+      markDirty(id);
+    }
+    // the side bar shows the armies left to place now and then
+    armiesLeft = (k % 3 == 0) ? -1 : k;
+    flushDirty(1 + k % 2);
+    keep();
+    redrawAll(map, 1 + k % 2);
+    wrongRedraw += differences();
+  }
+  save(dir, "redraw");
+
+  // the camera panned around, the joystick's steps and whole screens
+  long wrongPan = 0;
+  int pans = 0;
+  for (int k = 0; k < 60; ++k) {
+    int dx = (k < 20) ? 4 : (k < 40 ? -12 : 8);
+    int dy = (k % 3 == 0) ? 4 : -4;
+    if (k % 10 == 9) {
+      nextPageTouch(map, 2);
+    }
+    else {
+      panCamera(map, dx, dy);
+    }
+    keep();
+    redrawAll(map, 2);
+    wrongPan += differences();
+    pans++;
+  }
+  save(dir, "pan");
+
+  printf("%s: %dx%d map, %ld pixels wrong after redraws, %ld after %d pans, %ld wrong counts, joystick check %s\n",
+         dir, mapWidth, mapHeight, wrongRedraw, wrongPan, pans, wrongCounts, wrongJoystick ? "wrong" : "right");
+  printf("%s: %ld pixels wrong after counting armies down, %lu SPI bytes per number, %lu for the first\n",
+         dir, wrongArmies, armiesUpdate, armiesBytes);
+#if DISPLAY_LIST
+  printf("%s: display list used %d of %d commands, %u overflows\n",
+         dir, panel.mostRecorded(), DISPLAY_LIST_SIZE, panel.overflows());
+  wrongCounts += panel.overflows();
+#endif
+  return wrongRedraw + wrongPan + wrongCounts + wrongJoystick + wrongArmies > 0;
+}
+
+int main(int argc, char **argv) {
+  int failed = 0;
+  for (int i = 1; i < argc; ++i) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+      exit(check(argv[i]));
+    }
+    int status;
+    waitpid(child, &status, 0);
+    failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  }
+  return failed > 0;
+}
@@ -0,0 +1,84 @@
+/*
+  Checks FlatHashSet and HashTable against std::set with random inserts,
+  removes and lookups, then times both on a set the size of a
+  territory's neighbours.
+*/
+
+#include "mapGraph.h"
+#include <set>
+#include <chrono>
+
+// mapGraph.h expects the sketch to define this
+territory *territories;
+
+template <typename Set>
+static int stress() {
+  Set set;
+  std::set<int> expected;
+  for (long k = 0; k < 200000; ++k) {
+    uint8_t value = rand() % 64;
+    switch (rand() % 3) {
+      case 0:
+        if (set.insert(IntWrapper(value)) != expected.insert(value).second) {
+          return 1;
+        }
+        break;
+      case 1:
+        // HashTable may only remove what it holds
+        if (expected.erase(value)) {
+          set.remove(IntWrapper(value));
+        }
+        break;
+      default:
+        if (set.contains(IntWrapper(value)) != (expected.count(value) > 0)) {
+          return 1;
+        }
+        break;
+    }
+    if (set.size() != expected.size()) {
+      return 1;
+    }
+  }
+  // every item once, and nothing else
+  std::set<int> seen;
+  for (typename Set::Iterator i = set.startIterator(); !set.isEndIterator(i); i = set.nextIterator(i)) {
+    if (!expected.count(i.item().val) || !seen.insert(i.item().val).second) {
+      return 1;
+    }
+  }
+  return seen.size() != expected.size();
+}
+
+// 6 neighbours, then the lookups and the walk a turn does with them
+template <typename Set>
+static double rounds(long &sum) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int r = 0; r < 20000; ++r) {
+    Set set;
+    for (int v = 0; v < 6; ++v) {
+      set.insert(IntWrapper(v * 7));
+    }
+    for (int v = 0; v < 48; ++v) {
+      sum += set.contains(IntWrapper(v));
+    }
+    for (typename Set::Iterator i = set.startIterator(); !set.isEndIterator(i); i = set.nextIterator(i)) {
+      sum += i.item().val;
+    }
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  srand(1);
+  int flatWrong = stress<FlatHashSet<IntWrapper> >();
+  int hashWrong = stress<HashTable<IntWrapper> >();
+  printf("200000 random operations against std::set: FlatHashSet %s, HashTable %s\n",
+         flatWrong ? "wrong" : "ok", hashWrong ? "wrong" : "ok");
+
+  long sum = 0;
+  double hash = rounds<HashTable<IntWrapper> >(sum);
+  double flat = rounds<FlatHashSet<IntWrapper> >(sum);
+  printf("20000 rounds of 6 inserts, 48 lookups and a walk: HashTable %.1f ms, FlatHashSet %.1f ms (%ld)\n",
+         hash, flat, sum);
+  return flatWrong || hashWrong;
+}
@@ -0,0 +1,68 @@
+/*
+  Flips random territories and checks the team bitboards against the
+  territories' teams after each flip: owns(), territoriesOwned(),
+  enemyNeighbours() and winner(). Then times flip().
+
+  Usage: teams_test mapdir...
+*/
+
+#include "readFile.h"
+#include <time.h>
+
+territory *territories;
+
+static int check(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map = makeMap(territories);
+  int count = map->size();
+
+  srand(1);
+  int wrong = 0;
+  for (int k = 0; k < 10000; ++k) {
+    int id = rand() % count;
+    // sometimes the team it already has, which changes nothing
+    territories[id].team = 1 + rand() % 2;
+    map->flip(territories[id]);
+
+    int owned[3] = {0, 0, 0};
+    for (int t = 0; t < count; ++t) {
+      uint8_t team = territories[t].team;
+      owned[team == 1 || team == 2 ? team : 0]++;
+      wrong += map->owns(1, t) != (team == 1);
+      wrong += map->owns(2, t) != (team == 2);
+      if (team != 1 && team != 2) {
+        continue;
+      }
+      int enemies = 0;
+      for (int u = 0; u < count; ++u) {
+        enemies += map->isNeighbour(t, u) && territories[u].team == 3 - team;
+      }
+      wrong += map->enemyNeighbours(t) != enemies;
+    }
+    wrong += map->territoriesOwned(1) != owned[1];
+    wrong += map->territoriesOwned(2) != owned[2];
+    int winner = owned[1] == 0 ? 2 : (owned[2] == 0 ? 1 : -1);
+    wrong += map->winner() != winner;
+  }
+
+  clock_t start = clock();
+  for (long k = 0; k < 200000; ++k) {
+    int id = rand() % count;
+    territories[id].team = 3 - territories[id].team;
+    map->flip(territories[id]);
+  }
+  double flipTime = (clock() - start) * 1e9 / CLOCKS_PER_SEC / 200000;
+
+  printf("%s: 10000 flips checked, %d wrong, flip %.1f ns\n", dir, wrong, flipTime);
+  delete map;
+  delete[] territories;
+  return wrong > 0;
+}
+
+int main(int argc, char **argv) {
+  int failed = 0;
+  for (int i = 1; i < argc; ++i) {
+    failed += check(argv[i]);
+  }
+  return failed > 0;
+}
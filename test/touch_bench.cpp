@@ -0,0 +1,129 @@
+/*
+  Times touchGrid::find() against the binary search over the
+  territories sorted by x that risk.cpp used before it, and counts how
+  often each one picks another territory than a scan of all of them.
+  Half the touches land on a territory, half anywhere on the map.
+
+  Usage: touch_bench mapdir...
+*/
+
+#include "readFile.h"
+#include "touchGrid.h"
+#include <time.h>
+#include <algorithm>
+
+#define terrWidth 25
+#define terrHeight 25
+#define TOUCHES 200000
+
+territory *territories;
+
+// the binary search risk.cpp used before the grid
+static int oldTouched(uint8_t *xSortedIDs, int start, int end, int x_coord, int y_coord) {
+  int ID;
+  end--;
+  while (start <= end) {
+    ID = start + (end - start) / 2;
+    if (x_coord > terrX(xSortedIDs[ID]) && x_coord < terrX(xSortedIDs[ID]) + terrWidth) {
+      if (y_coord > terrY(xSortedIDs[ID]) && y_coord < terrY(xSortedIDs[ID]) + terrHeight) {
+        return xSortedIDs[ID];
+      }
+      return -1;
+    }
+    else if (x_coord < terrX(xSortedIDs[ID])) {
+      end = ID - 1;
+    }
+    else {
+      start = ID + 1;
+    }
+  }
+  return -1;
+}
+
+static bool byX(uint8_t a, uint8_t b) {
+  return terrX(a) < terrX(b);
+}
+
+static double seconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void bench(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map = makeMap(territories);
+  int count = map->size();
+  int width = 0, height = 0;
+  uint8_t *ids = new uint8_t[count];
+  for (int i = 0; i < count; ++i) {
+    ids[i] = i;
+    width = max(width, terrX(i) + terrWidth);
+    height = max(height, terrY(i) + terrHeight);
+  }
+  std::stable_sort(ids, ids + count, byX);
+  touchGrid grid;
+  grid.build(count, width, height, terrWidth, terrHeight);
+
+  int16_t *touchX = new int16_t[TOUCHES];
+  int16_t *touchY = new int16_t[TOUCHES];
+  int *truth = new int[TOUCHES];
+  srand(1);
+  for (int k = 0; k < TOUCHES; ++k) {
+    if (k & 1) {
+      int t = rand() % count;
+      touchX[k] = terrX(t) + 1 + rand() % (terrWidth - 2);
+      touchY[k] = terrY(t) + 1 + rand() % (terrHeight - 2);
+    }
+    else {
+      touchX[k] = rand() % width;
+      touchY[k] = rand() % height;
+    }
+    truth[k] = -1;
+    for (int i = 0; i < count; ++i) {
+      if (touchX[k] > terrX(i) && touchX[k] < terrX(i) + terrWidth
+          && touchY[k] > terrY(i) && touchY[k] < terrY(i) + terrHeight) {
+        truth[k] = i;
+      }
+    }
+  }
+
+  volatile long sum = 0;
+  double start = seconds();
+  for (int r = 0; r < 10; ++r) {
+    for (int k = 0; k < TOUCHES; ++k) {
+      sum += oldTouched(ids, 0, count, touchX[k], touchY[k]);
+    }
+  }
+  double searched = (seconds() - start) * 1e9 / (10.0 * TOUCHES);
+  start = seconds();
+  for (int r = 0; r < 10; ++r) {
+    for (int k = 0; k < TOUCHES; ++k) {
+      sum += grid.find(touchX[k], touchY[k]);
+    }
+  }
+  double found = (seconds() - start) * 1e9 / (10.0 * TOUCHES);
+
+  int oldWrong = 0, gridWrong = 0;
+  for (int k = 0; k < TOUCHES; ++k) {
+    oldWrong += oldTouched(ids, 0, count, touchX[k], touchY[k]) != truth[k];
+    gridWrong += grid.find(touchX[k], touchY[k]) != truth[k];
+  }
+
+  printf("%11d  %13.1f ns  %7.1f ns  %10.1f%% / %.1f%%\n",
+         count, searched, found, 100.0 * oldWrong / TOUCHES, 100.0 * gridWrong / TOUCHES);
+  delete[] ids;
+  delete[] touchX;
+  delete[] touchY;
+  delete[] truth;
+  delete map;
+  delete[] territories;
+}
+
+int main(int argc, char **argv) {
+  printf("territories  binary search  grid        wrong answers (old / grid)\n");
+  for (int i = 1; i < argc; ++i) {
+    bench(argv[i]);
+  }
+  return 0;
+}
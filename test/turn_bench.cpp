@@ -0,0 +1,276 @@
+/*
+  Times the end of a turn at 9600 baud: the handshake, the board and
+  its answer, and the side bar switching to the other player. Once the
+  way gameLoop does it now, and once the way it did before the link had
+  a send queue:
+    before - every record was flushed out before the next was encoded
+             (copied below from the old comm.h), and the side bar was
+             drawn after the answer came
+    now    - sendBoard() queues the board in the LinkSender, the side
+             bar is drawn while it goes out, then boardTaken() waits
+             for the answer
+
+  Player 1 runs here with Serial3 on a socket. A child process on the
+  other end stands in for the wire and for player 2. It works out when
+  each byte is out of a 9600 baud UART, and answers FRAME_HELLO and the
+  board once they are, as late as its answer takes to come back. The
+  side bar is charged 1 us per SPI byte (see render_bench), since the
+  PC draws it far faster than the board.
+
+  Built with TFT_STATS. Each map runs in its own process, like
+  render_bench.
+
+  Usage: turn_bench mapdir...
+*/
+
+#define main sketch_main
+#include "risk.cpp"
+#undef main
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// the territories a turn changes
+#define TURN_CHANGES 5
+// runs of each, the times are the average
+#define TURN_RUNS 3
+// how long a byte takes at 9600 baud, a start bit, 8 bits and a stop bit (s)
+#define BYTE_TIME (10.0 / 9600)
+
+static double seconds() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void sleepUntil(double when) {
+  double wait = when - seconds();
+  if (wait > 0) {
+    usleep(wait * 1e6);
+  }
+}
+
+// the wire and player 2: answers FRAME_HELLO with FRAME_READY and a
+// board with BOARD_ACK, once they are out and the answer is back
+static void farEnd(int fd) {
+  Serial3.attach(fd);
+  LinkReceiver link;
+  // when the last byte read is out of the sender's UART
+  double out = 0;
+  uint8_t pair[2];
+  size_t got = 0;
+  while (true) {
+    ssize_t n = read(fd, pair + got, 2 - got);
+    if (n <= 0) {
+      _exit(0);
+    }
+    got += n;
+    if (got < 2) {
+      continue;
+    }
+    got = 0;
+    out = std::max(out, seconds()) + BYTE_TIME;
+    link.feed(pair[1]);
+    linkEvent event;
+    while (link.next(event)) {
+      if (event.type == FRAME_HELLO || event.type == FRAME_BOARD_END) {
+        // a control frame is 5 bytes, the answer to this one is
+        // through the wire 5 bytes after this is
+        sleepUntil(out + 5 * BYTE_TIME);
+        FrameEncoder frame(Serial3);
+        frame.begin(event.type == FRAME_HELLO ? FRAME_READY : BOARD_ACK, 0);
+        frame.end();
+      }
+    }
+  }
+}
+
+// Serial3.flush() on the board: waits until every byte written so far
+// is out, the ones since the last call were written just now
+static double wireOut = 0;
+static unsigned long wireWritten = 0;
+
+static void wireFlush() {
+  unsigned long fresh = Serial3.written - wireWritten;
+  wireWritten = Serial3.written;
+  wireOut = std::max(wireOut, seconds()) + fresh * BYTE_TIME;
+  sleepUntil(wireOut);
+}
+
+// The handshake and board as comm.h had them before the send queue,
+// with wireFlush() for Serial3.flush()
+
+//send FRAME_HELLO wait for FRAME_READY
+bool oldHandshake(LinkReceiver &link)
+{
+    FrameEncoder frame(Serial3);
+    frame.begin(FRAME_HELLO, 0);
+    frame.end();
+    return wait(FRAME_READY, link, outgoing);
+}
+//send the territories that changed
+void oldSendPoints(territory*& allTerr, int length, const changeSet &changes)
+{
+    FrameEncoder frame(Serial3);
+    const int perFrame = FRAME_MAX_PAYLOAD / TERRITORY_RECORD_SIZE;
+    int sent = 0;
+    int next = 0;
+
+    wireFlush();
+    while (true)
+    {
+        //the records for the next frame are the next perFrame changed ones
+        int count = 0;
+        int first = next;
+        for (; next < length && count < perFrame; ++next)
+        {
+            count += changes.has(next);
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        frame.begin(FRAME_TERRITORIES, count * TERRITORY_RECORD_SIZE);
+        for (int i = first; i < next; ++i)
+        {
+            if (changes.has(i))
+            {
+                putTerritory(frame, allTerr[i]);
+                wireFlush();
+            }
+        }
+        frame.end();
+        sent += count;
+    }
+    frame.begin(FRAME_BOARD_END, 1);
+    frame.put(sent);
+    frame.end();
+}
+//send the changes and wait for the other board to take them, they are
+//kept until it does
+bool oldSyncBoard(territory*& allTerr, int length, changeSet &changes, LinkReceiver &link)
+{
+    //late answers to the handshake aren't the answer to this board
+    link.poll(Serial3);
+    link.discard();
+
+    oldSendPoints(allTerr, length, changes);
+    int32_t start = millis();
+    while ((millis() - start) <= 1000)
+    {
+        char reply = readReply(link, outgoing);
+        if (reply == BOARD_ACK)
+        {
+            changes.clear();
+            return true;
+        }
+        if (reply == SNAPSHOT_REQUEST)
+        {
+            changes.markAll();
+            return false;
+        }
+    }
+    return false;
+}
+
+// draws the side bar for player 2, and takes as long as the board would
+static void sideBarOnBoard() {
+  startFrame(tft);
+  sideBar(2);
+  delayMicroseconds(tft.spiBytes());
+}
+
+// marks every territory, or TURN_CHANGES spread over the map
+static void markChanges(int changed) {
+  unsynced.clear();
+  if (changed == NUM_TERR) {
+    unsynced.markAll();
+    return;
+  }
+  for (int k = 0; k < changed; ++k) {
+    unsynced.mark(k * NUM_TERR / changed);
+  }
+}
+
+// one end of turn, returns how long it took (ms)
+static double endOfTurn(bool queued, int changed, int *wrong) {
+  markChanges(changed);
+  double start = seconds();
+  if (queued) {
+    *wrong += !handshake(incoming, outgoing);
+    sendBoard(territories, NUM_TERR, unsynced, incoming, outgoing);
+    sideBarOnBoard();
+    *wrong += !boardTaken(unsynced, incoming, outgoing);
+  }
+  else {
+    *wrong += !oldHandshake(incoming);
+    // the wire is idle once the answer is back
+    wireWritten = Serial3.written;
+    *wrong += !oldSyncBoard(territories, NUM_TERR, unsynced, incoming);
+    sideBarOnBoard();
+  }
+  return (seconds() - start) * 1000;
+}
+
+static int bench(const char *dir) {
+  SD.root = dir;
+  masterMapGraph *map;
+  touchGrid grid;
+  // player 2's setup() doesn't negotiate a rate, the link stays at 9600
+  setup(map, grid, 2);
+
+  int ends[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) < 0) {
+    perror("socketpair");
+    return 1;
+  }
+  pid_t child = fork();
+  if (child == 0) {
+    close(ends[0]);
+    farEnd(ends[1]);
+  }
+  close(ends[1]);
+  fcntl(ends[0], F_SETFL, O_NONBLOCK);
+  Serial3.attach(ends[0]);
+
+  int wrong = 0;
+  int counts[2] = {NUM_TERR, TURN_CHANGES};
+  for (int c = 0; c < 2; ++c) {
+    double before = 0, now = 0;
+    unsigned long written = Serial3.written;
+    for (int r = 0; r < TURN_RUNS; ++r) {
+      before += endOfTurn(false, counts[c], &wrong);
+      now += endOfTurn(true, counts[c], &wrong);
+    }
+    // what player 1 sends in one end of turn
+    double bytes = (Serial3.written - written) / (2.0 * TURN_RUNS);
+    printf("%11d  %7d  %7.0f ms  %7.1f ms  %7.1f ms\n", NUM_TERR, counts[c],
+           bytes * BYTE_TIME * 1000, before / TURN_RUNS, now / TURN_RUNS);
+  }
+  close(ends[0]);
+  waitpid(child, NULL, 0);
+  if (wrong > 0) {
+    printf("%d handshakes or boards weren't answered\n", wrong);
+  }
+  return wrong;
+}
+
+int main(int argc, char **argv) {
+  printf("end of turn at 9600 baud: handshake, board and answer, side bar\n");
+  printf("territories  changed    the wire       before          now\n");
+  int failed = 0;
+  for (int i = 1; i < argc; ++i) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+      exit(bench(argv[i]) > 0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+  }
+  return failed > 0;
+}